@@ -0,0 +1,227 @@
+#pragma once
+
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// 初始化结果的本地缓存
+// 指纹 = 头部 (t, m, n, v, g, k) + 删除/写入/读取直方图，缓存分配方案、alpha
+// 和 TSP 顺序。完全命中时直接复用；头部的 m、n、v、g 相同且直方图的相对 L1
+// 距离不超过 ALLOC_CACHE_NEAR_DIST 时，取最近的条目给退火热启动
+//
+// 文件格式（文本，每个条目若干行）：
+//   entry <指纹>
+//   header t m n v g k
+//   hist <长度> <直方图...>
+//   solution <行> <列> <分配方案...>
+//   alpha <m> <m*m 个系数...>
+//   tsp <个数> { <长度> <顺序...> }
+namespace alloc_cache {
+
+struct Entry {
+  uint64_t key_{};                          // 指纹
+  std::vector<int> header_;                 // t m n v g k
+  std::vector<int> hist_;                   // 删除、写入、读取直方图依次拼接
+  std::vector<std::vector<int>> solution_;  // 分配方案
+  std::vector<std::vector<db>> alpha_;      // 资源混合惩罚系数
+  std::vector<std::vector<int>> tsp_;       // 各磁头区域的 TSP 顺序
+};
+
+// FNV-1a 哈希
+auto Fingerprint(const std::vector<int> &header, const std::vector<int> &hist)
+    -> uint64_t {
+  uint64_t h = 14695981039346656037ULL;
+  auto mix = [&h](int x) {
+    for (int b = 0; b < 4; b++) {
+      h ^= (static_cast<uint32_t>(x) >> (b * 8)) & 0xFF;
+      h *= 1099511628211ULL;
+    }
+  };
+  for (int x : header) {
+    mix(x);
+  }
+  for (int x : hist) {
+    mix(x);
+  }
+  return h;
+}
+
+// 直方图的相对 L1 距离，取值 [0, 1]
+auto Distance(const std::vector<int> &a, const std::vector<int> &b) -> db {
+  db diff = 0;
+  db total = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    diff += std::abs(a[i] - b[i]);
+    total += std::abs(a[i]) + std::abs(b[i]);
+  }
+  return total > 0 ? diff / total : 0.0;
+}
+
+// 读入 cnt 个值，失败返回 false
+template <typename T>
+auto ReadVec(std::istream &in, std::vector<T> &vec, int cnt) -> bool {
+  if (cnt < 0) {
+    return false;
+  }
+  vec.resize(cnt);
+  for (auto &x : vec) {
+    if (!(in >> x)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 按标签读入一段，标签不符或数据不完整返回 false
+auto ReadEntry(std::istream &in, Entry &e) -> bool {
+  std::string tag;
+  int rows = 0;
+  int cols = 0;
+  int len = 0;
+  if (!(in >> tag >> e.key_) || tag != "entry") {
+    return false;
+  }
+  if (!(in >> tag) || tag != "header" || !ReadVec(in, e.header_, 6)) {
+    return false;
+  }
+  if (!(in >> tag >> len) || tag != "hist" || !ReadVec(in, e.hist_, len)) {
+    return false;
+  }
+  if (!(in >> tag >> rows >> cols) || tag != "solution" || rows < 0) {
+    return false;
+  }
+  e.solution_.resize(rows);
+  for (auto &row : e.solution_) {
+    if (!ReadVec(in, row, cols)) {
+      return false;
+    }
+  }
+  if (!(in >> tag >> rows) || tag != "alpha" || rows < 0) {
+    return false;
+  }
+  e.alpha_.resize(rows);
+  for (auto &row : e.alpha_) {
+    if (!ReadVec(in, row, rows)) {
+      return false;
+    }
+  }
+  if (!(in >> tag >> rows) || tag != "tsp" || rows < 0) {
+    return false;
+  }
+  e.tsp_.resize(rows);
+  for (auto &order : e.tsp_) {
+    if (!(in >> len) || !ReadVec(in, order, len)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void WriteEntry(std::ostream &out, const Entry &e) {
+  out << "entry " << e.key_ << "\nheader";
+  for (int x : e.header_) {
+    out << ' ' << x;
+  }
+  out << "\nhist " << e.hist_.size();
+  for (int x : e.hist_) {
+    out << ' ' << x;
+  }
+  out << "\nsolution " << e.solution_.size() << ' '
+      << (e.solution_.empty() ? 0 : e.solution_[0].size());
+  for (const auto &row : e.solution_) {
+    for (int x : row) {
+      out << ' ' << x;
+    }
+  }
+  out << "\nalpha " << e.alpha_.size() << std::setprecision(17);
+  for (const auto &row : e.alpha_) {
+    for (db x : row) {
+      out << ' ' << x;
+    }
+  }
+  out << "\ntsp " << e.tsp_.size();
+  for (const auto &order : e.tsp_) {
+    out << ' ' << order.size();
+    for (int x : order) {
+      out << ' ' << x;
+    }
+  }
+  out << '\n';
+}
+
+// 读入缓存文件，文件不存在或损坏的部分直接忽略
+auto Load(const char *path = config::ALLOC_CACHE_PATH) -> std::vector<Entry> {
+  std::vector<Entry> entries;
+  std::ifstream in(path);
+  Entry e;
+  while (in && ReadEntry(in, e)) {
+    entries.push_back(std::move(e));
+    e = Entry();
+  }
+  return entries;
+}
+
+// 写回缓存文件，只保留最近的 ALLOC_CACHE_MAX_ENTRIES 个条目
+// 先写临时文件再改名，中途退出不会留下写了一半的缓存
+void Save(const std::vector<Entry> &entries,
+          const char *path = config::ALLOC_CACHE_PATH) {
+  std::string tmp = std::string(path) + ".tmp";
+  {
+    std::ofstream out(tmp);
+    if (!out) {
+      return;
+    }
+    auto cap = static_cast<size_t>(config::ALLOC_CACHE_MAX_ENTRIES);
+    size_t first = entries.size() > cap ? entries.size() - cap : 0;
+    for (size_t i = first; i < entries.size(); i++) {
+      WriteEntry(out, entries[i]);
+    }
+    if (!out) {
+      return;
+    }
+  }
+  std::rename(tmp.c_str(), path);
+}
+
+// 查找结果
+struct Match {
+  const Entry *entry_ = nullptr; // 命中的条目，未命中为空
+  bool exact_ = false;           // 是否完全命中
+  db dist_ = 0;                  // 直方图距离
+};
+
+// 查找完全相同或最接近的条目
+auto Find(const std::vector<Entry> &entries, const std::vector<int> &header,
+          const std::vector<int> &hist) -> Match {
+  uint64_t key = Fingerprint(header, hist);
+  Match best;
+  for (const auto &e : entries) {
+    if (static_cast<int>(e.solution_.size()) != header[1] ||
+        static_cast<int>(e.alpha_.size()) != header[1]) {
+      continue; // 损坏的条目
+    }
+    if (e.key_ == key && e.header_ == header && e.hist_ == hist) {
+      return {&e, true, 0.0};
+    }
+    // 分配方案的形状和阈值由 m、n、v、g 决定，它们必须相同
+    if (!std::equal(header.begin() + 1, header.begin() + 5,
+                    e.header_.begin() + 1) ||
+        e.hist_.size() != hist.size()) {
+      continue;
+    }
+    db d = Distance(e.hist_, hist);
+    if (d <= config::ALLOC_CACHE_NEAR_DIST &&
+        (best.entry_ == nullptr || d < best.dist_)) {
+      best = {&e, false, d};
+    }
+  }
+  return best;
+}
+
+} // namespace alloc_cache
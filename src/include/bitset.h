@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+// 两级位图：bits_ 的第 x 位表示 x 在集合中，summary_ 的第 w 位表示 bits_[w]
+// 非零。找不小于 pos 的下一个元素只需按字扫描并取最低位
+class LevelBitset {
+public:
+  // 参数：
+  // - n: 元素范围 [0, n)
+  // - full: 初始时是否包含所有元素
+  explicit LevelBitset(int n, bool full = false)
+      : n_(n), bits_((n + 63) >> 6, full ? ~0ULL : 0),
+        summary_((bits_.size() + 63) >> 6, 0) {
+    if (full) {
+      if ((n & 63) != 0) {
+        bits_.back() = (1ULL << (n & 63)) - 1; // 去掉超出范围的位
+      }
+      for (int w = 0; w < static_cast<int>(bits_.size()); w++) {
+        summary_[w >> 6] |= 1ULL << (w & 63);
+      }
+      count_ = n;
+    }
+  }
+
+  auto Test(int x) const -> bool { return ((bits_[x >> 6] >> (x & 63)) & 1) != 0; }
+
+  // 加入 x，返回之前是否不在集合中
+  auto Set(int x) -> bool {
+    int w = x >> 6;
+    uint64_t bit = 1ULL << (x & 63);
+    if ((bits_[w] & bit) != 0) {
+      return false;
+    }
+    bits_[w] |= bit;
+    summary_[w >> 6] |= 1ULL << (w & 63);
+    ++count_;
+    return true;
+  }
+
+  // 删除 x，返回之前是否在集合中
+  auto Reset(int x) -> bool {
+    int w = x >> 6;
+    uint64_t bit = 1ULL << (x & 63);
+    if ((bits_[w] & bit) == 0) {
+      return false;
+    }
+    bits_[w] &= ~bit;
+    if (bits_[w] == 0) {
+      summary_[w >> 6] &= ~(1ULL << (w & 63));
+    }
+    --count_;
+    return true;
+  }
+
+  // 不小于 pos 的第一个元素，没有返回 -1
+  auto Next(int pos) const -> int {
+    if (pos >= n_) {
+      return -1;
+    }
+    int w = pos >> 6;
+    uint64_t word = bits_[w] & (~0ULL << (pos & 63));
+    if (word != 0) {
+      return (w << 6) | __builtin_ctzll(word);
+    }
+    // 在 summary_ 中找 w 之后第一个非零的字
+    int nw = w + 1;
+    if (nw >= static_cast<int>(bits_.size())) {
+      return -1;
+    }
+    int sw = nw >> 6;
+    uint64_t sword = summary_[sw] & (~0ULL << (nw & 63));
+    while (sword == 0) {
+      if (++sw == static_cast<int>(summary_.size())) {
+        return -1;
+      }
+      sword = summary_[sw];
+    }
+    w = (sw << 6) | __builtin_ctzll(sword);
+    return (w << 6) | __builtin_ctzll(bits_[w]);
+  }
+
+  auto Count() const -> int { return count_; }
+
+private:
+  int n_;                         // 元素范围
+  int count_{0};                  // 元素个数
+  std::vector<uint64_t> bits_;    // 第一级位图
+  std::vector<uint64_t> summary_; // 第二级位图
+};
@@ -7,6 +7,10 @@ namespace config {
 // #define SINGLE_READ_MODE
 #define ISCERR
 #define USINGTSP // 是否使用TSP
+// #define CHECK_ALLOCATOR // 用模拟退火的结果校验其他资源分配器
+// #define USE_ALLOC_CACHE // 是否把初始化结果缓存到本地文件
+// #define RTQ_BENCH // 启动时运行读取队列的微基准，输出到 stderr 后退出
+// #define GC_BENCH // 启动时比较两种垃圾回收策略之后的读取代价，输出到 stderr 后退出
 // #define WRITE_BALANCE // 是否按照磁盘剩余空间排序
 
 constexpr int RANDOM_SEED = 0; // 随机数种子
@@ -18,21 +22,57 @@ constexpr int T = 200000;           // 模拟退火初始温度
 constexpr db EPS_T = 1e-8;          // 模拟退火终止温度
 constexpr db COOLING_RATE = 0.9999; // 模拟退火降温速率
 constexpr int MAX_ITER = 2000000;   // 模拟退火最大迭代次数
+constexpr int INIT_TIME_BUDGET_MS = 3000; // 初始化阶段（读完头部到输出 OK）的时间预算
+constexpr int CORRELATION_MAX_LAG = 2; // 滞后相关考虑的最大时间片分组数
+constexpr db LAG_WEIGHT = 0.0;          // 滞后相关计入相似度的权重，0 表示不用
 constexpr db BETA_VALUE = 1;        // 模拟退火、遗传算法超参数
 constexpr db GAMA_VALUE = 1;        // 遗传算法超参数，正则项系数
 
+constexpr int ANNEAL_THREADS = 4;          // 并行退火的链数（线程数）
+constexpr int PT_EXCHANGE_INTERVAL = 1000; // 并行回火相邻链交换状态的间隔
+constexpr db PT_LADDER = 2.0;              // 并行回火相邻链的温度比
+
+constexpr const char *ALLOC_CACHE_PATH = "alloc_cache.txt"; // 初始化缓存文件
+constexpr int ALLOC_CACHE_MAX_ENTRIES = 32; // 缓存保留的条目数
+constexpr db ALLOC_CACHE_NEAR_DIST = 0.2;   // 热启动允许的最大直方图距离
+constexpr db WARM_T = 100;                  // 热启动退火的初始温度
+constexpr db WARM_COOLING_RATE = 0.999;     // 热启动退火的降温速率
+
+constexpr int TSP_EXACT_MAX = 16; // 不超过该规模用精确 DP 求 TSP，否则用启发式
+constexpr int TSP_THREADS = 4;    // 并行求解 TSP 的线程数
+
 constexpr int SEGMENT_DEFAULT_CAPACITY = 10;    // 段默认容量
+constexpr bool SEGMENT_GROW = false;   // 段放不下时扩展到前后相邻的空闲块
+constexpr bool SEGMENT_SHRINK = false; // 垃圾回收时释放不再写入的段多余的尾部
+constexpr int SEGMENT_SLACK_MIN = 10;    // 收缩后段尾至少保留的空闲块数
+constexpr db SEGMENT_SLACK_RATIO = 0.25; // 收缩后段尾保留的空闲块占已用块的比例
+constexpr bool SEGMENT_SPLIT = true; // 垃圾回收时把段中间大的空闲区拆给缺空间的标签
+constexpr int SPLIT_MIN_RUN = 8;     // 拆分出去的空闲区至少多长
+constexpr bool ONLINE_REPLAN = false; // 每个时间片分组结束时重新求解资源分配
+constexpr int REPLAN_MAX_ITER = 20000; // 重新分配时热启动退火的迭代次数，不看墙钟
+constexpr int MAX_OBJECT_SIZE = 5;   // 对象的最大块数
+constexpr bool SIZE_CLASS_EXTENTS = true; // 段内按对象大小复用删除留下的连续空闲块
+constexpr int EXTENT_SLACK = 32; // 连续放置时最多比逐块写入多走多少个块
+constexpr int EXTENT_LIST_MAX = 64; // 每个段每种大小最多登记的空闲区数
+constexpr bool EXTENT_SPLIT_RUNS = false; // 放不下整段时按最长空闲段拆成尽量少的几段
 constexpr int PRINTER_BUF_CAPACITY = (1 << 20); // 打印缓冲区容量
+constexpr int PRINTER_OUT_CAPACITY = (1 << 22); // 输出缓冲区容量
+constexpr int READER_BUF_CAPACITY = (1 << 16);  // 输入缓冲区容量
 
 constexpr int K_POP_SIZE = 300;    // 种群大小
 constexpr int K_MAX_GEN = 3000;    // 最大迭代次数
 constexpr db K_CROSS_RATE = 0.5;   // 交叉概率
 constexpr db K_MUTATE_RATE = 0.05; // 变异概率
 constexpr int ELITE_NUM = 10;      // 精英个体数量
+constexpr int GA_ISLANDS = 4;            // 岛屿数量（线程数）
+constexpr int GA_MIGRATE_INTERVAL = 50;  // 岛屿间迁移的间隔代数
+constexpr int GA_MIGRANTS = 2;           // 每次迁移的个体数量
+constexpr int FLOW_REFINE_MAX_PASS = 200; // 确定性分配器局部优化的最大轮数
 
 constexpr int DISK_READ_FETCH_LEN = 32; // 规划最近的读取任务个数
 constexpr int REQ_BUSY_TIME = 105;
-int RTQ_DISK_PART_SIZE; // RTQ 给磁盘分区大小 NOLINT
+constexpr int RTQ_BUCKET_WIDTH = 16; // RTQ 热点区域索引的桶宽
+int RTQ_DISK_PART_SIZE; // RTQ 找热点区域的窗口宽度 NOLINT
 int JUMP_THRESHOLD;     // 热门块比当前块大多少时直接跳转 NOLINT
 int REAL_DISK_CNT;      // NOLINT
 
@@ -46,6 +86,36 @@ enum WRITEPOLICIES {
   compact   // 只在硬盘的前1/3读数据
 };
 
+// NOLINTNEXTLINE
+enum ANNEALMODES {
+  restart = 0, // 多条链独立退火，取最优
+  tempering    // 并行回火，相邻温度的链定期交换状态
+};
+
+constexpr ANNEALMODES ANNEAL_MODE = ANNEALMODES::restart;
+
+// NOLINTNEXTLINE
+enum ALLOCATORS {
+  anneal = 0, // 模拟退火
+  genetic,    // 遗传算法
+  flow        // 凸运输松弛 + 局部二次优化，确定性
+};
+
+constexpr ALLOCATORS ALLOCATOR = ALLOCATORS::anneal; // 资源分配使用的算法
+
+// NOLINTNEXTLINE
+enum GCPOLICIES {
+  greedy = 0, // 按段的顺序把段尾的块搬进段内的空洞
+  planned     // 压紧、搬回、拼接三类移动按每个块的收益统一排序
+};
+
+constexpr GCPOLICIES GC_POLICY = GCPOLICIES::greedy; // 垃圾回收策略
+constexpr db GC_GAIN_COMPACT = 1;   // 压紧段的一次移动的收益：扫描范围缩短一块
+constexpr db GC_GAIN_STRAY = 0.5;   // 主副本的一个块搬回本标签的段的收益
+constexpr db GC_GAIN_RUN = 24;      // 主副本少一处断开的收益：读取不用从 64 重新计费
+constexpr bool GC_AGE_TIERS = false; // 垃圾回收时是否把新对象集中到段首的热区
+constexpr int HOT_AGE = 1800;        // 写入后多少个时间片内的对象算热数据
+
 constexpr auto WritePolicy() {
   if (USE_COMPACT) {
     return WRITEPOLICIES::compact;
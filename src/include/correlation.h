@@ -0,0 +1,103 @@
+#pragma once
+
+#include "config.h"
+#include "data.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+// 标签之间的相关性
+// 构造时对每个标签的时间序列求一次秩（并列取平均秩），按标签连续存放，
+// 之后的斯皮尔曼矩阵和滞后相关都只在秩数组上做内积
+class CorrelationEngine {
+public:
+  // 参数：
+  // - data: m 行，每行是一个标签按时间片分组的序列
+  explicit CorrelationEngine(const Data &data)
+      : m_(data.M), len_(data.N), rank_(static_cast<size_t>(m_) * len_) {
+    std::vector<int> idx(len_);
+    for (int i = 0; i < m_; i++) {
+      const auto &row = data.vec[i];
+      db *rank = &rank_[static_cast<size_t>(i) * len_];
+      std::iota(idx.begin(), idx.end(), 0);
+      std::sort(idx.begin(), idx.end(),
+                [&](int a, int b) { return row[a] < row[b]; });
+      for (int l = 0; l < len_;) {
+        int r = l;
+        while (r < len_ && row[idx[r]] == row[idx[l]]) {
+          r++;
+        }
+        db avg = (l + 1 + r) / 2.0; // 第 l+1 到 r 名的平均秩
+        for (int k = l; k < r; k++) {
+          rank[idx[k]] = avg;
+        }
+        l = r;
+      }
+    }
+  }
+
+  // **斯皮尔曼秩相关矩阵**
+  // alpha[i][j] = 1 - 6 * sum(d^2) / (n * (n^2 - 1))，d 为同一时间片的秩差
+  auto Spearman() const -> std::vector<std::vector<db>> {
+    std::vector<std::vector<db>> alpha(m_, std::vector<db>(m_, 0.0));
+    db denom = std::max(1, len_ * (len_ * len_ - 1));
+    for (int i = 0; i < m_; i++) {
+      const db *ri = &rank_[static_cast<size_t>(i) * len_];
+      alpha[i][i] = len_ > 0 ? 1.0 : NAN;
+      for (int j = i + 1; j < m_; j++) {
+        const db *rj = &rank_[static_cast<size_t>(j) * len_];
+        db sum = 0.0;
+        for (int t = 0; t < len_; t++) {
+          db d = ri[t] - rj[t];
+          sum += d * d;
+        }
+        alpha[i][j] = alpha[j][i] = len_ > 0 ? 1.0 - 6.0 * sum / denom : NAN;
+      }
+    }
+    return alpha;
+  }
+
+  // **滞后相关**：标签 i 在第 t 个时间片、标签 j 在第 t + lag 个时间片的
+  // 秩的皮尔逊相关系数，值大说明 j 的高峰紧跟在 i 之后
+  auto Lagged(int i, int j, int lag) const -> db {
+    int n = len_ - lag;
+    if (n < 2) {
+      return 0.0;
+    }
+    const db *x = &rank_[static_cast<size_t>(i) * len_];
+    const db *y = &rank_[static_cast<size_t>(j) * len_ + lag];
+    db mx = std::accumulate(x, x + n, 0.0) / n;
+    db my = std::accumulate(y, y + n, 0.0) / n;
+    db sxy = 0.0;
+    db sxx = 0.0;
+    db syy = 0.0;
+    for (int t = 0; t < n; t++) {
+      sxy += (x[t] - mx) * (y[t] - my);
+      sxx += (x[t] - mx) * (x[t] - mx);
+      syy += (y[t] - my) * (y[t] - my);
+    }
+    return sxx > 0 && syy > 0 ? sxy / std::sqrt(sxx * syy) : 0.0;
+  }
+
+  // **对称的滞后相关矩阵**
+  // lag[i][j] = 1..maxLag 内 i 领先 j 或 j 领先 i 的最大相关系数，对角线为 0
+  auto LaggedMatrix(int maxLag) const -> std::vector<std::vector<db>> {
+    std::vector<std::vector<db>> lag(m_, std::vector<db>(m_, 0.0));
+    for (int i = 0; i < m_; i++) {
+      for (int j = i + 1; j < m_; j++) {
+        db best = 0.0;
+        for (int l = 1; l <= maxLag; l++) {
+          best = std::max({best, Lagged(i, j, l), Lagged(j, i, l)});
+        }
+        lag[i][j] = lag[j][i] = best;
+      }
+    }
+    return lag;
+  }
+
+private:
+  int m_;                // 标签数量
+  int len_;              // 序列长度（时间片分组数）
+  std::vector<db> rank_; // rank_[i * len_ + t]：标签 i 第 t 组的秩
+};
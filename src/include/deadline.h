@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+
+// 初始化阶段的墙钟预算
+// 各个求解器定期检查 Expired()，到期后提前结束并返回当前最优解
+namespace deadline {
+
+using clock = std::chrono::steady_clock;
+
+clock::time_point start_time = clock::now();                 // 预算开始时间
+clock::time_point end_time = clock::time_point::max();       // 截止时间
+
+// 开始计时，预算为 ms 毫秒
+void Start(int ms) {
+  start_time = clock::now();
+  end_time = start_time + std::chrono::milliseconds(ms);
+}
+
+// 取消截止时间，之后的求解只受迭代次数限制，结果不依赖机器快慢
+void Clear() { end_time = clock::time_point::max(); }
+
+// 是否已经超过截止时间
+auto Expired() -> bool { return clock::now() >= end_time; }
+
+// 从开始计时到现在经过的毫秒数
+auto ElapsedMs() -> long long {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() -
+                                                               start_time)
+      .count();
+}
+
+} // namespace deadline
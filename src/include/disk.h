@@ -1,8 +1,8 @@
 #pragma once
 
+#include "free_space.h"
 #include <cassert>
 #include <cstdint>
-#include <set>
 #include <vector>
 
 #ifndef _TIMESLICE
@@ -21,46 +21,32 @@ public:
 
   // 构造函数，初始化磁盘
   Disk(int disk_id, int V)
-      : disk_id_(disk_id), capacity_(V), storage_(V, {-1, -1}) {
-    // 初始化所有存储块为可用状态
-    for (int i = 0; i < capacity_; i++) {
-      free_block_idck_idck_.insert(i); // 将所有块的索引加入空闲块集合
-    }
+      : disk_id_(disk_id), capacity_(V), free_(V), storage_(V, {-1, -1}) {
     free_size_ = capacity_; // 空闲块数量等于总容量
   }
 
   // 写入数据到磁盘的空闲块
-  auto Write(int oid, int y) -> int {
-    auto it = free_block_idck_idck_.begin();   // 获取第一个空闲块
-    assert(it != free_block_idck_idck_.end()); // 确保存在空闲块
-    int idx = *it;                             // 获取空闲块的索引
-    storage_[idx] = {oid, y};                  // 将数据写入该块
-    free_block_idck_idck_.erase(it); // 从空闲块集合中移除该块
-    --free_size_;                    // 更新空闲块数量
-    return idx;                      // 返回写入的块索引
-  }
+  auto Write(int oid, int y) -> int { return WriteBlock(0, oid, y); }
 
   // 写入数据到指定块或之后的第一个空闲块
   auto WriteBlock(int bid, int oid, int y) -> int {
-    auto it = free_block_idck_idck_.lower_bound(
-        bid); // 找到第一个大于等于 bid 的空闲块
-    assert(it != free_block_idck_idck_.end()); // 确保存在空闲块
-    int idx = *it;                             // 获取空闲块的索引
-    storage_[idx] = {oid, y};                  // 将数据写入该块
-    free_block_idck_idck_.erase(it); // 从空闲块集合中移除该块
-    --free_size_;                    // 更新空闲块数量
-    return idx;                      // 返回写入的块索引
+    int idx = free_.NextFree(bid); // 找到第一个大于等于 bid 的空闲块
+    assert(idx != -1);             // 确保存在空闲块
+    storage_[idx] = {oid, y};      // 将数据写入该块
+    free_.Take(idx);               // 从空闲块集合中移除该块
+    --free_size_;                  // 更新空闲块数量
+    return idx;                    // 返回写入的块索引
   }
 
   // 删除指定索引的块中的数据
   void Delete(int idx) {
     assert(idx >= 0 && idx < capacity_); // 确保索引合法
-    if (free_block_idck_idck_.find(idx) != free_block_idck_idck_.end()) {
+    if (free_.IsFree(idx)) {
       return; // 如果块已经是空闲状态，则直接返回
     }
-    storage_[idx] = {-1, -1};          // 将块重置为空块
-    free_block_idck_idck_.insert(idx); // 将块重新加入空闲块集合
-    ++free_size_;                      // 更新空闲块数量
+    storage_[idx] = {-1, -1}; // 将块重置为空块
+    free_.Release(idx);       // 将块重新加入空闲块集合
+    ++free_size_;             // 更新空闲块数量
   }
 
   // 获取指定索引的存储块内容
@@ -74,19 +60,26 @@ public:
    * @param idx 起始编号
    * @param len 表示长度
    */
-  auto GetMaxLen(int idx = 0, int len = INT32_MAX) {
+  auto GetMaxLen(int idx = 0, int len = INT32_MAX) -> std::pair<int, int> {
     len = std::min(len, capacity_ - idx); // 确保长度不超过容量
-    int maxlen = 0;
-    int pos = 0; // 最大连续空闲块长度
-    for (int i = idx, cnt = 0; i < len; i++) {
-      cnt = (storage_[idx] == EMPTY_BLOCK) ? cnt + 1 : 0; // 计算连续空闲块
-      if (maxlen < cnt) {
-        maxlen = cnt;
-        pos = i - maxlen + 1;
-      }
-      maxlen = std::max(maxlen, cnt); // 更新最大长度
-    }
-    return std::pair(pos, maxlen); // 返回最大连续空闲块长度
+    return free_.LongestRun(idx, idx + len);
+  }
+
+  // 块 idx 是否空闲
+  auto IsFree(int idx) const -> bool { return free_.IsFree(idx); }
+
+  // 不小于 pos 的第一个空闲块，没有返回 -1
+  auto NextFree(int pos) const -> int { return free_.NextFree(pos); }
+
+  // 不大于 pos 的最后一个已占用块，没有返回 -1
+  auto PrevUsed(int pos) const -> int { return free_.PrevUsed(pos); }
+
+  // 从 pos 开始的连续空闲块数
+  auto FreeRunFrom(int pos) const -> int { return free_.RunFrom(pos); }
+
+  // addr 之后第一段长度不小于 len 的连续空闲块的起点，没有返回 -1
+  auto FirstFit(int addr, int len) const -> int {
+    return free_.FirstFit(addr, len);
   }
 
   auto GetFreeSize() -> int { return free_size_; } // 获取空闲块数量
@@ -95,9 +88,9 @@ public:
     assert(y >= 0 && y < capacity_); // 确保索引合法
     assert(storage_[x].first != -1 &&
            storage_[y].first == -1); // 确保至少有一个块为空
-    assert(!free_block_idck_idck_.count(x) && free_block_idck_idck_.count(y));
-    free_block_idck_idck_.insert(x);     // 将块重新加入空闲块集合
-    free_block_idck_idck_.erase(y);      // 更新空闲块数量
+    assert(!free_.IsFree(x) && free_.IsFree(y));
+    free_.Release(x);                    // 将块重新加入空闲块集合
+    free_.Take(y);                       // 更新空闲块数量
     std::swap(storage_[x], storage_[y]); // 交换两个块的内容
   }
 
@@ -105,8 +98,8 @@ private:
   const int disk_id_;  // 磁盘 ID
   const int capacity_; // 磁盘容量（块数）
 
-  int free_size_;                      // 当前空闲块数量
-  std::set<int> free_block_idck_idck_; // 空闲块集合
+  int free_size_;   // 当前空闲块数量
+  FreeSpace free_;  // 空闲块集合和空闲段索引
 
   std::vector<std::pair<int, int>>
       storage_; // 存储块，存储每个块的内容（对象 ID 和数据）
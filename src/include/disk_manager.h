@@ -1,5 +1,6 @@
 #pragma once
 
+#include "bitset.h"
 #include "config.h"
 #include "disk.h"
 #include "disk_manager.h"
@@ -35,7 +36,11 @@ public:
               SegmentManager *seg_mgr, std::vector<std::vector<db>> alpha,
               int N, int M, int V, int G, int K)
       : disk_cnt_(N), life_(G), obj_pool_(obj_pool), scheduler_(scheduler),
-        alpha_(std::move(alpha)), seg_mgr_(seg_mgr), tag_sf_(M) {
+        alpha_(std::move(alpha)), seg_mgr_(seg_mgr), tag_sf_(M),
+        stray_(N, LevelBitset(V)), loose_(N, LevelBitset(V)),
+        hot_(N, LevelBitset(V)),
+        cold_(N, LevelBitset(V)), spill_(N, std::vector<int>(M, 0)),
+        recorded_(N * (config::MAX_OBJECT_SIZE + 1), LevelBitset(V)) {
     std::iota(tag_sf_.begin(), tag_sf_.end(), 0);
     disks_.reserve(disk_cnt_); // 预留磁盘数量的空间
     mirror_disks_.reserve(disk_cnt_ + disk_cnt_);
@@ -51,13 +56,32 @@ public:
   // 获取磁盘数量
   auto GetDiskCnt() const -> int { return disk_cnt_; }
 
-  // 插入对象的第 kth 个副本到磁盘
+  // 插入对象的第 kth 个副本到磁盘，并统计副本是否连续存放
   // 参数：
   // - oid: 对象 ID
   // - kth: 副本编号
   // 返回值：是否插入成功
   auto Insert(int oid, int kth) -> bool {
+    if (!InsertReplica(oid, kth)) {
+      return false;
+    }
+    const auto &blocks = obj_pool_->GetObjAt(oid)->tdisk_[kth];
+    bool contiguous = true;
+    for (int j = 1, len = blocks.size(); j < len && contiguous; j++) {
+      contiguous = blocks[j] == blocks[j - 1] + 1;
+    }
+    int primary = kth == 0 ? 0 : 1;
+    if (primary == 0) {
+      Loosen(oid, obj_pool_->GetObjAt(oid)->idisk_[0]);
+    }
+    ++placed_[primary];
+    contiguous_[primary] += contiguous ? 1 : 0;
+    return true;
+  }
 
+  // 插入对象的第 kth 个副本到磁盘
+  // 返回值：是否插入成功
+  auto InsertReplica(int oid, int kth) -> bool {
     static std::mt19937 rng(config::RANDOM_SEED);
     auto object = obj_pool_->GetObjAt(oid); // 获取对象
 
@@ -120,12 +144,11 @@ public:
           block_id = disk.WriteBlock(0, oid, j); // 写入数据到磁盘
           object->tdisk_[kth][j] = block_id;     // 记录块 ID
         }
-        for (int i = 0, len = seg_mgr_->segs_.size(); i < len; i++) {
-          auto ptr = seg_mgr_->FindBlock(i, od, block_id);
-          if (ptr != nullptr) {
-            seg_mgr_->Write(ptr, 1); // 更新段信息
-          }
+        auto ptr = seg_mgr_->Locate(od, block_id);
+        if (ptr != nullptr) {
+          seg_mgr_->Write(ptr, 1); // 更新段信息
         }
+        Place(od, block_id);
       }
       return true;
     };
@@ -149,12 +172,11 @@ public:
         {
           auto block_id = disk.WriteBlock(0, oid, j); // 写入数据到磁盘
           object->tdisk_[kth][j] = block_id;          // 记录块 ID
-          for (int i = 0, len = seg_mgr_->segs_.size(); i < len; i++) {
-            auto ptr = seg_mgr_->FindBlock(i, od, block_id);
-            if (ptr != nullptr) {
-              seg_mgr_->Write(ptr, 1); // 更新段信息
-            }
+          auto ptr = seg_mgr_->Locate(od, block_id);
+          if (ptr != nullptr) {
+            seg_mgr_->Write(ptr, 1); // 更新段信息
           }
+          Place(od, block_id);
         }
       }
       return true; // 写入成功
@@ -177,9 +199,29 @@ public:
       auto &disk = disks_[od];
       auto ptr = seg_mgr_->Find(tag, od, object->size_); // 查找合适的段
       object->idisk_[kth] = od; // 设置副本所在磁盘
+      int start = ptr->disk_addr_;
+      // 放不下整段时在 [start, end) 里按最长空闲段填，-1 表示从 start 逐块写
+      int end = -1;
+      if constexpr (config::SIZE_CLASS_EXTENTS) {
+        int ext = FindExtent(ptr, object->size_);
+        if (ext != -1) {
+          start = ext;
+        } else if constexpr (config::EXTENT_SPLIT_RUNS) {
+          end = ExtentEnd(ptr, object->size_);
+        }
+      }
       for (int j = 0; j < object->size_; j++) {
         auto &block_id = object->tdisk_[kth][j];
-        block_id = disk.WriteBlock(ptr->disk_addr_, oid, j); // 写入数据到段
+        int pos = start;
+        if constexpr (config::EXTENT_SPLIT_RUNS) {
+          if (end != -1) {
+            // 每次都接着当前最长的空闲段写，对象被切成的段数尽量少
+            auto [a, len] = disk.GetMaxLen(start, end - start);
+            pos = len > 0 ? a : start;
+          }
+        }
+        block_id = disk.WriteBlock(pos, oid, j); // 写入数据到段
+        Place(od, block_id);
       }
       seg_mgr_->Write(ptr, object->size_); // 更新段信息
       return true;                         // 写入成功
@@ -191,32 +233,93 @@ public:
         for (auto od : sf) {
           if (kth == 0 &&
               write_to_disk(od, check_by_segment, write_by_segment)) {
+            ++write_segment_;
             return true;
           }
         }
+        // 本标签的段都放不下时先尝试扩展段，再考虑写到别的标签的段
+        if constexpr (config::SEGMENT_GROW) {
+          if (tag == object->tag_) {
+            for (auto od : sf) {
+              if (GrowSegment(tag, od, object->size_) &&
+                  write_to_disk(od, check_by_segment, write_by_segment)) {
+                ++write_segment_;
+                return true;
+              }
+            }
+          }
+        }
       }
     }
     for (auto od : sf) {
       if (write_to_disk(od, check_by_block, write_by_block)) {
+        ++write_block_;
+        spill_[od][object->tag_] += kth == 0 ? 1 : 0; // 主副本没能写进段里
         return true;
       }
     }
     for (auto od : sf) {
       if (write_to_disk(od, check_by_block_forced, write_by_block_forced)) {
+        ++write_forced_;
+        spill_[od][object->tag_] += kth == 0 ? 1 : 0;
         return true;
       }
     }
     return false; // 写入失败
   }
 
+  // 删除对象的一个副本后调用：副本的块连续且都在同一个段内时，
+  // 把这段空闲块按对象大小登记到段里，留给之后同样大小的对象
+  // 同一个起点只登记一次；列表满了 EXTENT_LIST_MAX 个时替换最靠后的一个，
+  // 离段首太远的起点本来也用不上
+  // 参数：
+  // - disk_id: 副本所在的磁盘 ID
+  // - blocks: 副本的块列表
+  void Recycle(int disk_id, const std::vector<int> &blocks) {
+    if constexpr (config::SIZE_CLASS_EXTENTS) {
+      int size = blocks.size();
+      if (size == 0 || size > config::MAX_OBJECT_SIZE) {
+        return;
+      }
+      auto seg = seg_mgr_->Locate(disk_id, blocks[0]);
+      if (seg == nullptr) {
+        return;
+      }
+      for (int j = 1; j < size; j++) {
+        if (blocks[j] != blocks[0] + j ||
+            seg_mgr_->Locate(disk_id, blocks[j]) != seg) {
+          return;
+        }
+      }
+      if (!recorded_[disk_id * (config::MAX_OBJECT_SIZE + 1) + size].Set(
+              blocks[0])) {
+        return; // 已经登记过
+      }
+      auto &list = seg->extents_[size];
+      if (static_cast<int>(list.size()) < config::EXTENT_LIST_MAX) {
+        list.push_back(blocks[0]);
+        return;
+      }
+      auto far = std::max_element(list.begin(), list.end());
+      int drop = std::max(*far, blocks[0]);
+      *far = std::min(*far, blocks[0]);
+      Forget(disk_id, size, drop);
+    }
+  }
+
   // 删除指定块的数据
   // 参数：
   // - tag: 数据标签
   // - disk_id: 磁盘 ID
   // - block_id: 块 ID
   void Delete(int tag, int disk_id, int block_id) {
+    auto &disk = disks_[disk_id];
+    if (disk.GetStorageAt(block_id).first == -1) {
+      return; // 块已经是空的
+    }
     seg_mgr_->Delete(tag, disk_id, block_id); // 删除段信息
-    disks_[disk_id].Delete(block_id);         // 删除磁盘块数据
+    disk.Delete(block_id);                    // 删除磁盘块数据
+    Unplace(disk_id, block_id);
   }
 
   // 从指定磁盘读取数据
@@ -272,7 +375,7 @@ public:
       return;
     }
     // 如果最近的任务都太远，就直接 jump
-    int target = scheduler_->GetRT(disk_id, disk.GetItr());
+    int target = JumpTarget(disk_id, task_k[0]);
     if (ReadDist(disk_id, task_k[0]) >= real_life) {
 
       disk.Jump(time, target);               // 跳转到目标位置
@@ -432,6 +535,21 @@ public:
 #endif
   }
 
+  // 需要跳转时选择目标：最近的待读块开始的窗口比最热的窗口少
+  // JUMP_THRESHOLD 个以上请求时，跳到最热的窗口，否则跳到最近的待读块
+  // 参数：
+  // - disk_id: 磁盘 ID
+  // - nearest: 最近的待读块
+  // 返回值：跳转目标
+  auto JumpTarget(int disk_id, int nearest) -> int {
+    auto [hot, hot_cnt] = scheduler_->GetHotRT(disk_id);
+    if (hot != -1 && hot_cnt - scheduler_->GetCntRT(disk_id, nearest) >
+                         config::JUMP_THRESHOLD) {
+      return hot;
+    }
+    return nearest;
+  }
+
   // 计算从当前位置到目标位置的距离
   // 参数：
   // - disk_id: 磁盘 ID
@@ -473,58 +591,745 @@ public:
     disk.Trans(x, y); // 磁盘交换数据
     // std::cerr<<"OK\n";
     seg_mgr_->Trans(disk_id, x, y); // 更新段信息
+    Place(disk_id, y);
+    Unplace(disk_id, x);
+    Loosen(oid, disk_id);
     // std::cerr<<"OK\n";
     // std::cerr<<"OK\n";
   }
-  auto GarbageCollection(int k) -> void {
+  // 垃圾回收：每个磁盘最多移动 k 次，交换方案写入 printer::GCAdd
+  // 段的空洞数、尾部位置和错位的块都随写入、删除、移动增量维护，
+  // 这里不扫描磁盘
+  // 参数：
+  // - policy: 垃圾回收策略，默认用 config::GC_POLICY
+  auto GarbageCollection(int k,
+                         config::GCPOLICIES policy = config::GC_POLICY)
+      -> void {
+    if constexpr (config::WritePolicy() == config::WRITEPOLICIES::compact) {
+      std::vector<int> budget(disk_cnt_, k);
+      if (policy == config::GCPOLICIES::planned) {
+        Plan(budget);
+      }
+      for (int d = 0; d < disk_cnt_; d++) {
+        // 先补段内的空洞：按段写入的对象从段首找空闲块，空洞会把对象拆散
+        if (policy == config::GCPOLICIES::greedy) {
+          Compact(d, budget[d]);
+        }
+        if constexpr (config::GC_AGE_TIERS) {
+          Tier(d, budget[d]);
+        }
+        if constexpr (config::SEGMENT_SHRINK) {
+          ShrinkSegments(d);
+        }
+        if constexpr (config::SEGMENT_SPLIT) {
+          seg_merge_ += seg_mgr_->Merge(d);
+          SplitSegments(d);
+        }
+        if (!target_.empty()) {
+          Retarget(d);
+        }
+        std::fill(spill_[d].begin(), spill_[d].end(), 0);
+      }
+    }
+  }
 
-    // return;
+  // 设置在线重新分配的目标：solution 的格式和初始化的分配方案相同，
+  // 标签 j 在磁头区域 z 上的目标容量是 solution[j][z]
+  void SetTarget(const std::vector<std::vector<int>> &solution) {
+    target_ = solution;
+  }
 
-    if constexpr (config::WritePolicy() == config::WRITEPOLICIES::compact) {
-      // static bool f = false;
-      // static std::vector<std::vector<int>> idx(disk_cnt_);
-      // [&]() {
-      //   if (f) {
-      //     return;
-      //   }
-      //   for (int i = 0, len = tag_sf_.size(); i < len; i++) {
-      //     for (auto &s : seg_mgr_->segs_[i]) {
-      //       idx[s.disk_id_].push_back(s.disk_addr_);
-      //     }
-      //   }
-      //   for (int i = 0; i < disk_cnt_; i++) {
-      //     idx[i].emplace_back(seg_mgr_->seg_disk_capacity_[i]);
-      //   }
-      //   for (auto &v : idx) {
-      //     std::sort(v.begin(), v.end());
-      //   }
-      //   f = true;
-      // }();
-      std::vector<int> lef(disk_cnt_, k);
-      for (auto &seg_list : seg_mgr_->segs_) {
-        for (auto &seg : seg_list) {
-          auto &disk = disks_[seg.disk_id_];
-          for (int i = seg.disk_addr_, j = seg.disk_addr_ + seg.size_ - 1;
-               i < j; i++) {
-            if (disk.storage_[i].first != -1) {
-              continue;
-            }
-            while (i < j && disk.storage_[j].first == -1) {
-              j--;
-            }
-            if (i >= j) {
-              break;
-            }
-            if (lef[seg.disk_id_]-- > 0) {
-              Trans(seg.disk_id_, j, i);
+#ifdef ISCERR
+  // 输出垃圾回收的统计：各类移动的次数和仍然错位的块数
+  void ReportGC() {
+    int stray = 0;
+    for (auto &s : stray_) {
+      stray += s.Count();
+    }
+    std::cerr << "gc: repatriate=" << gc_repatriate_
+              << " compact=" << gc_compact_ << " join=" << gc_join_
+              << " tier=" << gc_tier_
+              << " stray=" << stray << '\n';
+    if constexpr (config::GC_AGE_TIERS) {
+      ReportTiers();
+    }
+    std::cerr << "write: segment=" << write_segment_
+              << " block=" << write_block_ << " forced=" << write_forced_
+              << " grow=" << seg_grow_ << " shrink=" << seg_shrink_
+              << " split=" << seg_split_ << " merge=" << seg_merge_
+              << " retarget=" << seg_retarget_
+              << " extent_reuse=" << write_extent_reuse_ << '\n';
+    std::cerr << "contiguous: primary="
+              << static_cast<db>(contiguous_[0]) / std::max(1LL, placed_[0])
+              << " replica="
+              << static_cast<db>(contiguous_[1]) / std::max(1LL, placed_[1])
+              << '\n';
+  }
+
+  // 输出各层的占用：段内热块、冷块的数量，以及热块落在热区内的比例
+  void ReportTiers() {
+    Age();
+    long long hot = 0;
+    long long cold = 0;
+    long long in_band = 0;
+    for (auto &seg_list : seg_mgr_->segs_) {
+      for (auto &seg : seg_list) {
+        hot += seg.hot_;
+        cold += seg.used_ - seg.hot_;
+        auto &bits = hot_[seg.disk_id_];
+        int end = seg.disk_addr_ + seg.hot_;
+        for (int b = bits.Next(seg.disk_addr_); b != -1 && b < end;
+             b = bits.Next(b + 1)) {
+          ++in_band;
+        }
+      }
+    }
+    std::cerr << "tier: hot=" << hot << " cold=" << cold << " hot_in_band="
+              << (hot == 0 ? 1.0 : static_cast<db>(in_band) / hot) << '\n';
+  }
+#endif
+
+private:
+  // 块被写入或移入后调用：更新所在段，块不在本标签的段内时记为错位
+  // 开启冷热分层时，对象编号不小于 cold_oid_ 的是热数据
+  void Place(int disk_id, int block_id) {
+    int oid = disks_[disk_id].GetStorageAt(block_id).first;
+    bool hot = false;
+    if constexpr (config::GC_AGE_TIERS) {
+      hot = oid >= cold_oid_;
+      (hot ? hot_ : cold_)[disk_id].Set(block_id);
+    }
+    seg_mgr_->Occupy(disk_id, block_id, hot);
+    auto seg = seg_mgr_->Locate(disk_id, block_id);
+    if (seg == nullptr || seg->tag_ != obj_pool_->GetObjAt(oid)->tag_) {
+      stray_[disk_id].Set(block_id);
+    }
+  }
+
+  // 块被删除或移出后调用
+  void Unplace(int disk_id, int block_id) {
+    bool hot = false;
+    if constexpr (config::GC_AGE_TIERS) {
+      hot = hot_[disk_id].Reset(block_id);
+      cold_[disk_id].Reset(block_id);
+    }
+    seg_mgr_->Vacate(disk_id, block_id, disks_[disk_id].PrevUsed(block_id),
+                     hot);
+    stray_[disk_id].Reset(block_id);
+    loose_[disk_id].Reset(block_id);
+  }
+
+  // 重新标记对象 oid 在磁盘 disk_id 上的主副本是否需要整体搬动：有错位的块
+  // 或者块不连续。规划垃圾回收时从这些块找候选，不用扫描所有对象
+  void Loosen(int oid, int disk_id) {
+    auto object = obj_pool_->GetObjAt(oid);
+    if (object->idisk_[0] != disk_id) {
+      return; // 只有主副本会被读取
+    }
+    const auto &blocks = object->tdisk_[0];
+    bool contiguous = true;
+    for (int j = 1, len = blocks.size(); j < len && contiguous; j++) {
+      contiguous = blocks[j] == blocks[j - 1] + 1;
+    }
+    bool stray = false;
+    for (int b : blocks) {
+      stray |= stray_[disk_id].Test(b);
+    }
+    for (int b : blocks) {
+      contiguous && !stray ? loose_[disk_id].Reset(b) : loose_[disk_id].Set(b);
+    }
+  }
+
+  // 对象按写入顺序编号，写入超过 HOT_AGE 个时间片的对象从热变冷，
+  // 只需把 cold_oid_ 往后推，每个对象只处理一次
+  void Age() {
+    while (cold_oid_ < obj_pool_->GetSize()) {
+      auto object = obj_pool_->GetObjAt(cold_oid_);
+      if (timeslice - object->birth_ < config::HOT_AGE) {
+        break;
+      }
+      if (object->valid_) {
+        for (int r = 0; r < 3; r++) {
+          int d = object->idisk_[r];
+          for (int b : object->tdisk_[r]) {
+            if (hot_[d].Reset(b)) {
+              cold_[d].Set(b);
+              seg_mgr_->Cool(d, b);
             }
           }
         }
       }
+      ++cold_oid_;
+    }
+  }
+
+  // 段内分层：段首 hot_ 个块是热区，热区里的冷对象整体搬到段内热区外的
+  // 连续空闲块，再把热区外的热对象整体搬进热区腾出的连续空闲块，
+  // 搬完后对象仍然连续，磁头读新对象时扫过的范围更短
+  void Tier(int disk_id, int &budget) {
+    Age();
+    auto &disk = disks_[disk_id];
+    auto &hot = hot_[disk_id];
+    auto &cold = cold_[disk_id];
+    for (auto &seg_list : seg_mgr_->segs_) {
+      for (auto &seg : seg_list) {
+        if (seg.disk_id_ != disk_id) {
+          continue;
+        }
+        int band = seg.disk_addr_ + seg.hot_;
+        int end = seg.disk_addr_ + seg.capacity_;
+        // 热区里的冷对象
+        for (int c = cold.Next(seg.disk_addr_); c != -1 && c < band && budget > 0;
+             c = cold.Next(c + 1)) {
+          int oid = disk.GetStorageAt(c).first;
+          int len = obj_pool_->GetObjAt(oid)->size_;
+          int dest = disk.FirstFit(band, len);
+          if (len > budget || dest == -1 || dest + len > end ||
+              !Relocate(oid, disk_id, dest)) {
+            continue;
+          }
+          budget -= len;
+          gc_tier_ += len;
+        }
+        // 热区外的热对象
+        for (int h = hot.Next(band); h != -1 && h < end && budget > 0;
+             h = hot.Next(h + 1)) {
+          int oid = disk.GetStorageAt(h).first;
+          int len = obj_pool_->GetObjAt(oid)->size_;
+          int dest = disk.FirstFit(seg.disk_addr_, len);
+          if (len > budget || dest == -1 || dest + len > band ||
+              !Relocate(oid, disk_id, dest)) {
+            continue;
+          }
+          budget -= len;
+          gc_tier_ += len;
+        }
+      }
+    }
+  }
+
+  // 把对象在磁盘 disk_id 上的副本整体搬到 dest 开始的连续空闲块
+  // 调用方保证 [dest, dest + size) 空闲
+  // 返回值：是否搬动了，正在读的对象不搬，免得磁头错过它
+  auto Relocate(int oid, int disk_id, int dest) -> bool {
+    auto object = obj_pool_->GetObjAt(oid);
+    int r = 0;
+    while (object->idisk_[r] != disk_id) {
+      ++r;
+    }
+    auto blocks = object->tdisk_[r]; // Trans 会改写 tdisk_，先复制
+    for (int x : blocks) {
+      if (scheduler_->Pending(disk_id, x)) {
+        return false;
+      }
+    }
+    for (int i = 0, len = blocks.size(); i < len; i++) {
+      Trans(disk_id, blocks[i], dest + i);
+    }
+    return true;
+  }
+
+  // 段 seg 里放 size 个块的对象时允许使用的范围 [段首, 返回值)：不比从段首
+  // 逐块写入走得更远（多 EXTENT_SLACK 个块以内），免得为了连续把对象放到段
+  // 的深处，拉长磁头扫过的范围
+  // 返回值：范围的末尾，段首之后的空闲块不够时返回 -1
+  auto ExtentEnd(Segment *seg, int size) -> int {
+    auto &disk = disks_[seg->disk_id_];
+    int last = seg->disk_addr_ - 1; // 逐块写入时最后一个块的位置
+    for (int j = 0; j < size && last != -1; j++) {
+      last = disk.NextFree(last + 1);
+    }
+    if (last == -1) {
+      return -1;
+    }
+    return std::min(last + config::EXTENT_SLACK + 1,
+                    seg->disk_addr_ + seg->capacity_);
+  }
+
+  // 在段 seg 里为 size 个块的对象找 ExtentEnd 范围内的连续空闲块：先复用
+  // 同样大小的对象删除后留下的空闲区，再找最短的够长的连续空闲块
+  // 返回值：起点，没有合适的位置时返回 -1
+  auto FindExtent(Segment *seg, int size) -> int {
+    auto &disk = disks_[seg->disk_id_];
+    int end = ExtentEnd(seg, size);
+    if (end == -1) {
+      return -1;
+    }
+    int cls = std::min(size, config::MAX_OBJECT_SIZE);
+    auto &list = seg->extents_[cls];
+    int best = -1;
+    int best_i = -1;
+    for (int i = 0; i < static_cast<int>(list.size());) {
+      int a = list[i];
+      bool ok = true;
+      for (int j = 0; j < size && ok; j++) {
+        ok = disk.IsFree(a + j) &&
+             seg_mgr_->Locate(seg->disk_id_, a + j) == seg;
+      }
+      if (!ok) {
+        list[i] = list.back(); // 已经被占用或不再属于本段
+        list.pop_back();
+        Forget(seg->disk_id_, cls, a);
+        continue;
+      }
+      if (a + size <= end && (best == -1 || a < best)) {
+        best = a;
+        best_i = i;
+      }
+      ++i;
+    }
+    if (best != -1) {
+      list[best_i] = list.back(); // 马上就要写入，从列表里拿掉
+      list.pop_back();
+      Forget(seg->disk_id_, cls, best);
+      ++write_extent_reuse_;
+      return best;
+    }
+    // 范围内最短的够长的连续空闲块（最佳适配），长度正好时直接用
+    // 按整段的长度比较：越过范围末尾的长空闲段不算紧凑
+    int best_len = 0;
+    for (int a = disk.FirstFit(seg->disk_addr_, size);
+         a != -1 && a + size <= end;) {
+      int run = disk.FreeRunFrom(a);
+      if (best == -1 || run < best_len) {
+        best = a;
+        best_len = run;
+      }
+      if (run == size) {
+        break;
+      }
+      a = disk.FirstFit(a + run, size);
+    }
+    return best;
+  }
+
+  // 起点 a、大小 size 的空闲区不再登记在任何段里
+  void Forget(int disk_id, int size, int a) {
+    recorded_[disk_id * (config::MAX_OBJECT_SIZE + 1) + size].Reset(a);
+  }
+
+  // 标签 tag 在磁盘 disk_id 上的段放不下 size 个块时，把段扩展到前后相邻的
+  // 连续空闲块上（至多翻倍，至少够放下这个对象），先从更长的一边拿
+  // 相邻的块属于别的段时，只拿那个段空着、让出后仍留足余量的部分
+  // 返回值：是否有段扩展到了能放下
+  auto GrowSegment(int tag, int disk_id, int size) -> bool {
+    for (auto &seg : seg_mgr_->segs_[tag]) {
+      if (seg.disk_id_ != disk_id) {
+        continue;
+      }
+      int need = seg.size_ + size - seg.capacity_;
+      if (need <= 0) {
+        continue;
+      }
+      int after = RoomAfter(&seg);
+      int before = RoomBefore(&seg);
+      if (after + before < need) {
+        continue;
+      }
+      int want = std::min(after + before, std::max(need, seg.capacity_));
+      int back = after >= before ? std::min(after, want)
+                                 : want - std::min(before, want);
+      if (back > 0) {
+        seg_mgr_->GrowBack(&seg, back);
+      }
+      if (want > back) {
+        seg_mgr_->GrowFront(&seg, want - back);
+      }
+      seg_grow_ += want;
+      return true;
+    }
+    return false;
+  }
+
+  // 段尾之后能扩展的块数：磁盘上连续的空闲块里，不属于任何段的部分，
+  // 或者后一个段段首空着、让出后仍留足余量的部分
+  auto RoomAfter(Segment *seg) -> int {
+    int d = seg->disk_id_;
+    int end = seg->disk_addr_ + seg->capacity_;
+    int zone = seg_mgr_->zone_[d];
+    int lim = seg->disk_addr_ < zone ? zone : seg_mgr_->seg_disk_capacity_[d];
+    int run = std::min(disks_[d].FreeRunFrom(end), lim - end); // 不跨区域
+    if (run <= 0) {
+      return 0;
+    }
+    if (auto nx = seg_mgr_->Locate(d, end); nx != nullptr) {
+      int keep = std::max(nx->size_, nx->used_) + Slack(nx);
+      return std::max(0, std::min(run, nx->capacity_ - keep));
+    }
+    int len = 0;
+    while (len < run && seg_mgr_->Locate(d, end + len) == nullptr) {
+      ++len;
+    }
+    return len;
+  }
+
+  // 段首之前能扩展的块数：磁盘上连续的空闲块里，不属于任何段的部分，
+  // 或者前一个段段尾空着、让出后仍留足余量的部分
+  auto RoomBefore(Segment *seg) -> int {
+    int d = seg->disk_id_;
+    int a = seg->disk_addr_;
+    int zone = seg_mgr_->zone_[d];
+    if (a == 0 || a == zone) {
+      return 0; // 不跨磁头区域
+    }
+    int run = std::min(a - 1 - disks_[d].PrevUsed(a - 1),
+                       a > zone ? a - zone : a);
+    if (auto pv = seg_mgr_->Locate(d, a - 1); pv != nullptr) {
+      return std::max(0, std::min(run, pv->capacity_ - Keep(pv)));
+    }
+    int len = 0;
+    while (len < run && seg_mgr_->Locate(d, a - 1 - len) == nullptr) {
+      ++len;
+    }
+    return len;
+  }
+
+  // 段让出容量后至少保留的空闲块：SEGMENT_SLACK_MIN 和已用块的
+  // SEGMENT_SLACK_RATIO 中较大的那个
+  static auto Slack(const Segment *seg) -> int {
+    return std::max(config::SEGMENT_SLACK_MIN,
+                    static_cast<int>(seg->used_ * config::SEGMENT_SLACK_RATIO));
+  }
+
+  // 从段尾让出容量时段至少保留的容量：最后一个被占用的块之前的部分加上
+  // 余量，并且不少于 size_
+  static auto Keep(const Segment *seg) -> int {
+    return std::max(seg->tail_ - seg->disk_addr_ + Slack(seg), seg->size_);
+  }
+
+  // 垃圾回收时释放磁盘 disk_id 上各段尾部多余的空闲容量，
+  // 留下 SEGMENT_SLACK_MIN 和已用块的 SEGMENT_SLACK_RATIO 中较大的余量，
+  // 释放的块可以被前面的段扩展占用
+  void ShrinkSegments(int disk_id) {
+    for (auto &seg_list : seg_mgr_->segs_) {
+      for (auto &seg : seg_list) {
+        if (seg.disk_id_ != disk_id) {
+          continue;
+        }
+        bool growing = seg.size_ > seg.last_size_;
+        seg.last_size_ = seg.size_;
+        if (growing) {
+          continue; // 这段时间还在写入的段不收缩
+        }
+        int cap = Keep(&seg);
+        if (cap < seg.capacity_) {
+          seg_shrink_ += seg.capacity_ - cap;
+          seg_mgr_->Shrink(&seg, cap);
+        }
+      }
+    }
+  }
+
+  // 按在线重新分配的目标调整磁盘 disk_id 上各标签的段，两个磁头区域分开算：
+  // 超出目标的标签释放段尾的空闲容量，不足的标签先向后扩展，
+  // 再占用同一区域里不属于任何段的空闲区。已经写了数据的块不动，
+  // 段尾被占着的部分等之后的垃圾回收把数据压到段首后再释放
+  void Retarget(int disk_id) {
+    auto &disk = disks_[disk_id];
+    int m = target_.size();
+    auto cur = target_; // 标签 × 磁头区域，只用到本磁盘的两列
+    for (int j = 0; j < m; j++) {
+      cur[j][disk_id] = cur[j][disk_id + disk_cnt_] = 0;
+      for (auto &seg : seg_mgr_->segs_[j]) {
+        if (seg.disk_id_ == disk_id) {
+          cur[j][seg_mgr_->Zone(&seg)] += seg.capacity_;
+        }
+      }
+    }
+    for (int j = 0; j < m; j++) {
+      for (auto &seg : seg_mgr_->segs_[j]) {
+        if (seg.disk_id_ != disk_id) {
+          continue;
+        }
+        int z = seg_mgr_->Zone(&seg);
+        int over = cur[j][z] - target_[j][z];
+        int cap = std::max(Keep(&seg), seg.capacity_ - over);
+        if (over > 0 && cap < seg.capacity_) {
+          cur[j][z] -= seg.capacity_ - cap;
+          seg_retarget_ += seg.capacity_ - cap;
+          seg_mgr_->Shrink(&seg, cap);
+        }
+      }
+    }
+    for (int j = 0; j < m; j++) {
+      for (auto &seg : seg_mgr_->segs_[j]) {
+        if (seg.disk_id_ != disk_id) {
+          continue;
+        }
+        int z = seg_mgr_->Zone(&seg);
+        if (cur[j][z] >= target_[j][z]) {
+          continue;
+        }
+        int run = disk.FreeRunFrom(seg.disk_addr_ + seg.capacity_);
+        int grown =
+            seg_mgr_->Grow(&seg, std::min(run, target_[j][z] - cur[j][z]));
+        cur[j][z] += grown;
+        seg_retarget_ += grown;
+      }
+    }
+    // 不属于任何段的空闲区分给同一区域里还缺容量的标签，优先选和前面的段
+    // 最相关的标签（TSP 把相关的标签排在相邻的位置），其次选差得最多的
+    int zone = seg_mgr_->zone_[disk_id];
+    int end = seg_mgr_->seg_disk_capacity_[disk_id];
+    for (int a = 0; a < end;) {
+      if (seg_mgr_->Locate(disk_id, a) != nullptr ||
+          disk.GetStorageAt(a).first != -1) {
+        ++a;
+        continue;
+      }
+      int z = a < zone ? disk_id : disk_id + disk_cnt_;
+      int lim = a < zone ? zone : end;
+      int b = a;
+      while (b < lim && seg_mgr_->Locate(disk_id, b) == nullptr &&
+             disk.GetStorageAt(b).first == -1) {
+        ++b;
+      }
+      auto front = a > 0 ? seg_mgr_->Locate(disk_id, a - 1) : nullptr;
+      int j = -1;
+      for (int u = 0; u < m; u++) {
+        int need = target_[u][z] - cur[u][z];
+        if (need < config::SEGMENT_DEFAULT_CAPACITY) {
+          continue;
+        }
+        if (j == -1) {
+          j = u;
+          continue;
+        }
+        db du = front != nullptr ? alpha_[front->tag_][u] : 0;
+        db dj = front != nullptr ? alpha_[front->tag_][j] : 0;
+        if (du > dj || (du == dj && need > target_[j][z] - cur[j][z])) {
+          j = u;
+        }
+      }
+      int len = j == -1 ? 0 : std::min(b - a, target_[j][z] - cur[j][z]);
+      if (len < config::SEGMENT_DEFAULT_CAPACITY) {
+        a = b;
+        continue;
+      }
+      seg_mgr_->Add(disk_id, a, j, len);
+      cur[j][z] += len;
+      seg_retarget_ += len;
+      a += len;
+    }
+  }
+
+  // 段中间有不短于 SPLIT_MIN_RUN 的空闲区时，把最长的一段拆给
+  // 上一轮有主副本没能写进段里、按块写到了这个磁盘上、和该段标签最相关的标签
+  // 只拆两头都有数据的空闲区：段首空着的部分留给本标签之后写入
+  void SplitSegments(int disk_id) {
+    auto &disk = disks_[disk_id];
+    for (int t = 0, m = seg_mgr_->segs_.size(); t < m; t++) {
+      for (auto &seg : seg_mgr_->segs_[t]) {
+        if (seg.disk_id_ != disk_id || seg.Holes() < config::SPLIT_MIN_RUN) {
+          continue;
+        }
+        // 段内第一个有数据的块
+        int head = seg.disk_addr_ + disk.FreeRunFrom(seg.disk_addr_);
+        auto [a, len] = disk.GetMaxLen(head, seg.tail_ - head);
+        if (len < config::SPLIT_MIN_RUN) {
+          continue;
+        }
+        int to = -1;
+        for (int u = 0; u < m; u++) {
+          if (u != t && spill_[disk_id][u] > 0 &&
+              (to == -1 || alpha_[t][u] > alpha_[t][to])) {
+            to = u;
+          }
+        }
+        if (to == -1) {
+          return; // 没有缺空间的标签
+        }
+        int size = seg.size_;
+        auto [mid, right] = seg_mgr_->Split(&seg, a, len, to);
+        size -= Recount(&seg) + (right != nullptr ? Recount(right) : 0);
+        seg_mgr_->seg_disk_size_[disk_id] -= size;
+        --spill_[disk_id][to];
+        ++seg_split_;
+      }
+    }
+  }
+
+  // 按磁盘上的实际占用重新统计段 seg 的 used_ / hot_ / tail_ / size_
+  // 返回值：新的 size_
+  auto Recount(Segment *seg) -> int {
+    auto &disk = disks_[seg->disk_id_];
+    seg->used_ = seg->hot_ = 0;
+    seg->tail_ = seg->disk_addr_;
+    for (int b = seg->disk_addr_, end = b + seg->capacity_; b < end; b++) {
+      if (disk.GetStorageAt(b).first != -1) {
+        ++seg->used_;
+        seg->hot_ += hot_[seg->disk_id_].Test(b) ? 1 : 0;
+        seg->tail_ = b + 1;
+      }
+    }
+    seg->size_ = seg->used_;
+    return seg->size_;
+  }
+
+  // 垃圾回收的候选移动
+  struct Move {
+    db gain_;      // 每移动一个块的收益：估计之后读取省下的令牌数
+    int disk_;     // 磁盘 ID
+    Segment *seg_; // 压紧的段，整体搬对象时为 nullptr
+    int oid_;      // 整体搬动的对象
+  };
+
+  // 按收益规划垃圾回收，候选移动有三类：
+  // - 压紧：段尾的块搬进段内最前面的空洞，段的扫描范围缩短一块，段尾空出的
+  //   连续空间留给之后写入的对象；这一轮有主副本没写进段里的标签收益加倍
+  // - 搬回：写到别的标签区域或段区域之外的主副本整体搬进本标签的段
+  // - 拼接：段内不连续的主副本整体搬到一段连续的空闲块，省下读中间空隙的令牌
+  // compact 模式下只读主副本，其他副本不参与。搬回和拼接的候选只从 loose_
+  // 里找，规划的开销和要整理的主副本数有关，和写入过的对象总数无关。
+  // 按每个块的收益从大到小执行，每个磁盘不超过 budget[d] 次移动，所有磁盘的
+  // 预算用完就停；执行前重新检查，被前面的移动影响的跳过
+  void Plan(std::vector<int> &budget) {
+    std::vector<Move> moves;
+    for (auto &seg_list : seg_mgr_->segs_) {
+      for (auto &seg : seg_list) {
+        if (budget[seg.disk_id_] > 0 && seg.Holes() > 0) {
+          bool spilled = spill_[seg.disk_id_][seg.tag_] > 0;
+          db gain = config::GC_GAIN_COMPACT * (spilled ? 2 : 1);
+          moves.push_back({gain, seg.disk_id_, &seg, -1});
+        }
+      }
+    }
+    std::vector<int> oids;
+    for (int d = 0; d < disk_cnt_; d++) {
+      if (budget[d] == 0) {
+        continue;
+      }
+      auto &bits = loose_[d];
+      for (int b = bits.Next(0); b != -1; b = bits.Next(b + 1)) {
+        auto [oid, idx] = disks_[d].GetStorageAt(b);
+        if (idx == 0) {
+          oids.push_back(oid); // 每个对象只取一次
+        }
+      }
+    }
+    std::sort(oids.begin(), oids.end()); // 收益相同时按编号，结果和磁盘顺序无关
+    for (int oid : oids) {
+      db gain = MoveGain(oid);
+      if (gain > 0) {
+        moves.push_back({gain, obj_pool_->GetObjAt(oid)->idisk_[0], nullptr,
+                         oid});
+      }
+    }
+    std::stable_sort(moves.begin(), moves.end(),
+                     [](const Move &a, const Move &b) {
+                       return a.gain_ > b.gain_;
+                     });
+    int active = std::count_if(budget.begin(), budget.end(),
+                               [](int b) { return b > 0; });
+    for (auto &mv : moves) {
+      if (active == 0) {
+        break; // 所有磁盘的预算都用完了
+      }
+      int &left = budget[mv.disk_];
+      if (left == 0) {
+        continue;
+      }
+      if (mv.seg_ != nullptr) {
+        CompactSegment(mv.seg_, left);
+      } else if (MoveGain(mv.oid_) > 0) {
+        MoveReplica(mv.oid_, left);
+      }
+      active -= left == 0 ? 1 : 0;
+    }
+  }
+
+  // 把对象的主副本整体搬进本标签的段能省下的读取令牌数，平均到每个块
+  // 返回值：不需要搬、正在读或没有收益时返回 0
+  auto MoveGain(int oid) -> db {
+    auto object = obj_pool_->GetObjAt(oid);
+    if (!object->valid_) {
+      return 0;
+    }
+    int d = object->idisk_[0];
+    const auto &blocks = object->tdisk_[0];
+    int stray = 0;
+    int runs = 1;
+    int gaps = 0;
+    for (int j = 0; j < object->size_; j++) {
+      if (scheduler_->Pending(d, blocks[j])) {
+        return 0; // 正在读的对象不搬，免得磁头错过它
+      }
+      stray += stray_[d].Test(blocks[j]) ? 1 : 0;
+      if (j > 0 && blocks[j] != blocks[j - 1] + 1) {
+        ++runs;
+        gaps += std::max(0, blocks[j] - blocks[j - 1] - 1);
+      }
+    }
+    db gain = config::GC_GAIN_STRAY * stray +
+              config::GC_GAIN_RUN * (runs - 1) + gaps;
+    return gain / object->size_;
+  }
+
+  // 把对象的主副本搬到本标签的段内第一段足够长的连续空闲块，搬完后对象
+  // 连续，原来的位置还给所在的段或空闲区
+  // 返回值：是否搬动了
+  auto MoveReplica(int oid, int &budget) -> bool {
+    auto object = obj_pool_->GetObjAt(oid);
+    int d = object->idisk_[0];
+    int len = object->size_;
+    if (len > budget) {
+      return false;
+    }
+    auto &disk = disks_[d];
+    int dest = -1;
+    for (auto &seg : seg_mgr_->segs_[object->tag_]) {
+      if (seg.disk_id_ != d) {
+        continue;
+      }
+      int pos = disk.FirstFit(seg.disk_addr_, len);
+      if (pos != -1 && pos + len <= seg.disk_addr_ + seg.capacity_) {
+        dest = pos;
+        break;
+      }
+    }
+    if (dest == -1) {
+      return false; // 本标签的段里放不下
+    }
+    bool stray = false;
+    for (int x : object->tdisk_[0]) {
+      stray |= stray_[d].Test(x);
+    }
+    if (!Relocate(oid, d, dest)) {
+      return false;
+    }
+    budget -= len;
+    (stray ? gc_repatriate_ : gc_join_) += len;
+    return true;
+  }
+
+  // 压紧磁盘 disk_id 上的段：把段尾的块搬进段内最前面的空洞，
+  // 段尾空出连续的空间留给之后按段写入的对象
+  void Compact(int disk_id, int &budget) {
+    std::vector<Segment *> segs;
+    for (auto &seg_list : seg_mgr_->segs_) {
+      for (auto &seg : seg_list) {
+        if (seg.disk_id_ == disk_id && seg.Holes() > 0) {
+          segs.push_back(&seg);
+        }
+      }
+    }
+    for (auto seg : segs) {
+      CompactSegment(seg, budget);
+    }
+  }
+
+  // 压紧一个段，直到没有空洞或预算用完
+  void CompactSegment(Segment *seg, int &budget) {
+    auto &disk = disks_[seg->disk_id_];
+    while (budget > 0 && seg->Holes() > 0) {
+      int hole = disk.NextFree(seg->disk_addr_); // 段内第一个空洞
+      assert(hole != -1 && hole < seg->tail_ - 1);
+      Trans(seg->disk_id_, seg->tail_ - 1, hole);
+      --budget;
+      ++gc_compact_;
     }
   }
 
-private:
   const int disk_cnt_;                   // 磁盘数量
   const int life_;                       // 磁盘生命周期
   ObjectPool *obj_pool_;                 // 对象池
@@ -534,4 +1339,30 @@ private:
   std::vector<MirrorDisk> mirror_disks_; // 虚拟磁盘
   std::vector<std::vector<db>> alpha_;   // 相似矩阵
   std::vector<int> tag_sf_;              // 标签排序
+  std::vector<LevelBitset> stray_; // 每个磁盘上不在本标签段内的块
+  // 每个磁盘上错位或不连续的主副本的块，垃圾回收整体搬动的候选
+  std::vector<LevelBitset> loose_;
+  long long gc_repatriate_{0};     // 垃圾回收搬回本标签段的块数
+  long long gc_compact_{0};        // 垃圾回收压紧段的移动次数
+  long long gc_join_{0};           // 垃圾回收把段内对象拼成连续的块数
+  std::vector<LevelBitset> hot_;   // 每个磁盘上热数据的块
+  std::vector<LevelBitset> cold_;  // 每个磁盘上冷数据的块
+  int cold_oid_{0};                // 编号小于它的对象都是冷数据
+  long long gc_tier_{0};           // 垃圾回收冷热分层的移动次数
+  long long write_segment_{0};     // 写到段里的副本数
+  long long write_block_{0};       // 按块写到段区域之外的副本数
+  long long write_forced_{0};      // 强制写到任意空闲块的副本数
+  long long seg_grow_{0};          // 段扩展的块数
+  long long seg_shrink_{0};        // 段收缩释放的块数
+  // 每个磁盘上每个标签这一轮没能写进段里、按块写到这个磁盘的主副本数
+  std::vector<std::vector<int>> spill_;
+  long long seg_split_{0};         // 拆分段的次数
+  long long seg_merge_{0};         // 合并段的次数
+  std::vector<std::vector<int>> target_; // 在线重新分配的目标：标签 × 磁头区域
+  long long seg_retarget_{0};      // 按重新分配的目标调整的块数
+  long long write_extent_reuse_{0}; // 复用同样大小对象留下的空闲区的次数
+  // 已经登记的空闲区起点：下标是 磁盘 × (MAX_OBJECT_SIZE + 1) + 大小
+  std::vector<LevelBitset> recorded_;
+  std::array<long long, 2> placed_{};     // 写入的副本数：主副本、其他副本
+  std::array<long long, 2> contiguous_{}; // 其中块连续存放的副本数
 };
\ No newline at end of file
@@ -0,0 +1,248 @@
+#pragma once
+#include "config.h"
+#include "deadline.h"
+#include "resource_allocator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+// 最小费用流，SPFA 找最短增广路，只用于小规模的取整问题
+class MinCostFlow {
+public:
+  explicit MinCostFlow(int n) : g_(n) {}
+
+  void AddEdge(int u, int v, int cap, db cost) {
+    g_[u].push_back(e_.size());
+    e_.push_back({v, cap, cost});
+    g_[v].push_back(e_.size());
+    e_.push_back({u, 0, -cost});
+  }
+
+  // 返回值：{流量, 费用}
+  auto Solve(int s, int t) -> std::pair<int, db> {
+    int n = g_.size();
+    int flow = 0;
+    db cost = 0;
+    std::vector<db> dist(n);
+    std::vector<int> pre(n);
+    std::vector<bool> inq(n);
+    while (true) {
+      std::fill(dist.begin(), dist.end(), config::INF);
+      std::fill(pre.begin(), pre.end(), -1);
+      std::deque<int> q{s};
+      dist[s] = 0;
+      while (!q.empty()) {
+        int u = q.front();
+        q.pop_front();
+        inq[u] = false;
+        for (int id : g_[u]) {
+          const auto &e = e_[id];
+          if (e.cap_ > 0 && dist[u] + e.cost_ < dist[e.to_] - 1e-12) {
+            dist[e.to_] = dist[u] + e.cost_;
+            pre[e.to_] = id;
+            if (!inq[e.to_]) {
+              inq[e.to_] = true;
+              q.push_back(e.to_);
+            }
+          }
+        }
+      }
+      if (pre[t] == -1) {
+        break;
+      }
+      int aug = INT32_MAX;
+      for (int v = t; v != s; v = e_[pre[v] ^ 1].to_) {
+        aug = std::min(aug, e_[pre[v]].cap_);
+      }
+      for (int v = t; v != s; v = e_[pre[v] ^ 1].to_) {
+        e_[pre[v]].cap_ -= aug;
+        e_[pre[v] ^ 1].cap_ += aug;
+      }
+      flow += aug;
+      cost += aug * dist[t];
+    }
+    return {flow, cost};
+  }
+
+  // 第 id 条加入的边（AddEdge 的调用顺序）上的流量
+  auto GetFlow(int id) const -> int { return e_[id * 2 + 1].cap_; }
+
+private:
+  struct Edge {
+    int to_;
+    int cap_;
+    db cost_;
+  };
+  std::vector<std::vector<int>> g_;
+  std::vector<Edge> e_;
+};
+
+// 确定性的资源分配器：凸运输松弛 + 局部二次优化
+// 1. 去掉混合项后，使每格平方和最小的松弛解是按比例分配
+//    q[i][j] = r[i] * v / sum(r)，用最小费用流把它取整成行和、列和都精确的整数解
+//    （优先把小数部分大的格子向上取整）
+// 2. 在四格交换的邻域上做首次改进的局部搜索，每个候选交换的惩罚变化是交换量 d
+//    的分段二次函数，用缓存的 S[j][i] = sum_k a[i][k] x[k][j] 在 O(1) 内求出，
+//    取端点、顶点和超额阈值处的最优 d
+// 没有随机数，同样的输入得到同样的解，通常几毫秒内完成
+class FlowOptimizer : public AllocationProblem {
+private:
+  std::vector<int> x_; // 当前解，按容器连续存放
+  std::vector<db> s_;  // s_[j * m_ + i] = sum_k a_[i][k] * x[k][j]
+
+  // **凸运输松弛并取整**
+  void Relax() {
+    long long total = 0;
+    for (int r : r_) {
+      total += r;
+    }
+    x_.assign(n_ * m_, 0);
+    std::vector<int> row_rem = r_, col_rem(n_, v_);
+    std::vector<db> frac(n_ * m_, 0.0);
+    for (int i = 0; i < m_; ++i) {
+      for (int j = 0; j < n_; ++j) {
+        db q = total > 0 ? static_cast<db>(r_[i]) * v_ / total : 0.0;
+        int f = static_cast<int>(std::floor(q));
+        x_[j * m_ + i] = f;
+        frac[j * m_ + i] = q - f;
+        row_rem[i] -= f;
+        col_rem[j] -= f;
+      }
+    }
+    // 源点 -> 资源 i -> 容器 j -> 汇点，每格最多再加 1
+    int s = m_ + n_;
+    int t = s + 1;
+    MinCostFlow mcf(t + 1);
+    for (int i = 0; i < m_; ++i) {
+      for (int j = 0; j < n_; ++j) {
+        mcf.AddEdge(i, m_ + j, 1, -frac[j * m_ + i]);
+      }
+    }
+    for (int i = 0; i < m_; ++i) {
+      mcf.AddEdge(s, i, std::max(0, row_rem[i]), 0);
+    }
+    for (int j = 0; j < n_; ++j) {
+      mcf.AddEdge(m_ + j, t, std::max(0, col_rem[j]), 0);
+    }
+    mcf.Solve(s, t);
+    for (int i = 0; i < m_; ++i) {
+      for (int j = 0; j < n_; ++j) {
+        x_[j * m_ + i] += mcf.GetFlow(i * n_ + j);
+      }
+    }
+  }
+
+  // 容器 j 中资源 i 变化 d 后更新缓存
+  void Apply(int j, int i, int d) {
+    x_[j * m_ + i] += d;
+    db *s = &s_[j * m_];
+    const db *a = &a_[i * m_];
+    for (int k = 0; k < m_; ++k) {
+      s[k] += a[k] * d;
+    }
+  }
+
+  // 超额惩罚的变化量
+  auto OverflowDelta(int x, int d) const -> db {
+    return OverflowPenalty(x + d) - OverflowPenalty(x);
+  }
+
+  // 容器 j1 中 i1 加 d、i2 减 d，容器 j2 相反时的惩罚变化量
+  auto MoveDelta(int j1, int j2, int i1, int i2, int d) const -> db {
+    const int *c1 = &x_[j1 * m_];
+    const int *c2 = &x_[j2 * m_];
+    db g = (s_[j1 * m_ + i1] - s_[j1 * m_ + i2]) -
+           (s_[j2 * m_ + i1] - s_[j2 * m_ + i2]);
+    return g * d - 2 * a_[i1 * m_ + i2] * d * d + OverflowDelta(c1[i1], d) +
+           OverflowDelta(c1[i2], -d) + OverflowDelta(c2[i2], d) +
+           OverflowDelta(c2[i1], -d);
+  }
+
+  // 找出交换量 d 的最优取值
+  // 返回值：{d, 惩罚变化量}，找不到改进时 d 为 0
+  auto BestMove(int j1, int j2, int i1, int i2) const -> std::pair<int, db> {
+    int hi = std::min(x_[j1 * m_ + i2], x_[j2 * m_ + i1]);
+    if (hi <= 0) {
+      return {0, 0.0};
+    }
+    db g = (s_[j1 * m_ + i1] - s_[j1 * m_ + i2]) -
+           (s_[j2 * m_ + i1] - s_[j2 * m_ + i2]);
+    db a = a_[i1 * m_ + i2];
+    int cand[8] = {1, hi,
+                   // 不考虑超额项时二次函数的顶点
+                   a < 0 ? static_cast<int>(std::lround(g / (4 * a))) : 1,
+                   // 四个格子穿过阈值 l 的位置
+                   l_ - x_[j1 * m_ + i1], x_[j1 * m_ + i2] - l_,
+                   l_ - x_[j2 * m_ + i2], x_[j2 * m_ + i1] - l_, hi / 2};
+    std::pair<int, db> best = {0, 0.0};
+    for (int d : cand) {
+      d = std::clamp(d, 1, hi);
+      db delta = MoveDelta(j1, j2, i1, i2, d);
+      if (delta < best.second - 1e-9) {
+        best = {d, delta};
+      }
+    }
+    return best;
+  }
+
+public:
+  // **构造函数**
+  FlowOptimizer(int m, int n, int v, int l, const std::vector<int> &r,
+                const std::vector<std::vector<db>> &alpha,
+                db beta = config::BETA_VALUE, db gama = config::GAMA_VALUE)
+      : AllocationProblem(m, n, v, l, r, alpha, beta, gama) {}
+
+  // **求解**
+  auto Solve(bool iscerr = false,
+             int maxPass = config::FLOW_REFINE_MAX_PASS) -> void {
+    [[maybe_unused]] auto start = std::chrono::steady_clock::now();
+    Relax();
+    s_.assign(n_ * m_, 0.0);
+    for (int j = 0; j < n_; ++j) {
+      for (int i = 0; i < m_; ++i) {
+        for (int k = 0; k < m_; ++k) {
+          s_[j * m_ + i] += a_[i * m_ + k] * x_[j * m_ + k];
+        }
+      }
+    }
+    [[maybe_unused]] db relaxed = ComputePenalty(x_);
+    int pass = 0;
+    for (bool improved = true;
+         improved && pass < maxPass && !deadline::Expired(); ++pass) {
+      improved = false;
+      for (int j1 = 0; j1 < n_; ++j1) {
+        for (int j2 = j1 + 1; j2 < n_; ++j2) {
+          for (int i1 = 0; i1 < m_; ++i1) {
+            for (int i2 = 0; i2 < m_; ++i2) {
+              if (i1 == i2) {
+                continue;
+              }
+              auto [d, delta] = BestMove(j1, j2, i1, i2);
+              if (d == 0) {
+                continue;
+              }
+              Apply(j1, i1, d);
+              Apply(j1, i2, -d);
+              Apply(j2, i2, d);
+              Apply(j2, i1, -d);
+              improved = true;
+            }
+          }
+        }
+      }
+    }
+    best_x_ = Unflatten(x_);
+    best_penalty_ = ComputePenalty(x_);
+#ifdef ISCERR
+    std::cerr << "flow: relaxed=" << relaxed << " refined=" << best_penalty_
+              << " pass=" << pass << " ms="
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << '\n';
+#endif
+  }
+};
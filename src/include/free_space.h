@@ -0,0 +1,187 @@
+#pragma once
+
+#include "bitset.h"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+// 磁盘的空闲空间
+// - 两级位图 free_ 求不小于某个位置的第一个空闲块
+// - 线段树每个节点记录区间内从左端开始、到右端结束的空闲段长度和最长空闲段，
+//   O(log V) 求「addr 之后第一段长度不小于 L 的空闲段」和「[a, b) 内最长的
+//   空闲段」
+class FreeSpace {
+public:
+  // 参数：
+  // - V: 磁盘容量（块数），初始时全部空闲
+  explicit FreeSpace(int V) : v_(V), free_(V, true), tree_(4 * std::max(1, V)) {
+    Build(1, 0, v_ - 1);
+  }
+
+  auto IsFree(int x) const -> bool { return free_.Test(x); }
+
+  auto GetFreeSize() const -> int { return free_.Count(); }
+
+  // 不小于 pos 的第一个空闲块，没有返回 -1
+  auto NextFree(int pos) const -> int { return free_.Next(pos); }
+
+  // 从 pos 开始的连续空闲块数
+  auto RunFrom(int pos) const -> int {
+    return pos < 0 || pos >= v_ ? 0 : Query(1, 0, v_ - 1, pos, v_ - 1).pre_;
+  }
+
+  // 不大于 pos 的最后一个已占用块，没有返回 -1
+  auto PrevUsed(int pos) const -> int {
+    pos = std::min(pos, v_ - 1);
+    return pos < 0 ? -1 : PrevUsed(1, 0, v_ - 1, pos);
+  }
+
+  // 占用块 x
+  void Take(int x) {
+    if (free_.Reset(x)) {
+      Update(1, 0, v_ - 1, x, false);
+    }
+  }
+
+  // 释放块 x
+  void Release(int x) {
+    if (free_.Set(x)) {
+      Update(1, 0, v_ - 1, x, true);
+    }
+  }
+
+  // addr 之后（含）第一段长度不小于 len 的空闲段的起点，没有返回 -1
+  auto FirstFit(int addr, int len) const -> int {
+    if (len <= 0) {
+      return std::clamp(addr, 0, v_);
+    }
+    if (addr >= v_ || tree_[1].best_ < len) {
+      return -1;
+    }
+    int carry = 0;
+    return FirstFit(1, 0, v_ - 1, std::max(0, addr), len, carry);
+  }
+
+  // [a, b) 内最长的空闲段
+  // 返回值：{起点, 长度}，没有空闲块时长度为 0
+  auto LongestRun(int a, int b) const -> std::pair<int, int> {
+    a = std::max(a, 0);
+    b = std::min(b, v_);
+    if (a >= b) {
+      return {a, 0};
+    }
+    Node res = Query(1, 0, v_ - 1, a, b - 1);
+    return {res.best_ == 0 ? a : res.pos_, res.best_};
+  }
+
+private:
+  struct Node {
+    int len_{0};  // 区间长度
+    int pre_{0};  // 从左端开始的空闲段长度
+    int suf_{0};  // 到右端结束的空闲段长度
+    int best_{0}; // 最长空闲段长度
+    int pos_{0};  // 最长空闲段的起点（最左的那个）
+  };
+
+  // 合并相邻的两个区间，mid 是右区间的起点
+  static auto Merge(const Node &a, const Node &b, int mid) -> Node {
+    Node c;
+    c.len_ = a.len_ + b.len_;
+    c.pre_ = a.pre_ == a.len_ ? a.len_ + b.pre_ : a.pre_;
+    c.suf_ = b.suf_ == b.len_ ? b.len_ + a.suf_ : b.suf_;
+    c.best_ = a.best_;
+    c.pos_ = a.pos_;
+    if (a.suf_ + b.pre_ > c.best_) {
+      c.best_ = a.suf_ + b.pre_;
+      c.pos_ = mid - a.suf_;
+    }
+    if (b.best_ > c.best_) {
+      c.best_ = b.best_;
+      c.pos_ = b.pos_;
+    }
+    return c;
+  }
+
+  void Build(int o, int l, int r) {
+    if (l == r) {
+      tree_[o] = {1, 1, 1, 1, l};
+      return;
+    }
+    int mid = (l + r) / 2;
+    Build(o * 2, l, mid);
+    Build(o * 2 + 1, mid + 1, r);
+    tree_[o] = Merge(tree_[o * 2], tree_[o * 2 + 1], mid + 1);
+  }
+
+  void Update(int o, int l, int r, int x, bool free) {
+    if (l == r) {
+      int f = free ? 1 : 0;
+      tree_[o] = {1, f, f, f, l};
+      return;
+    }
+    int mid = (l + r) / 2;
+    if (x <= mid) {
+      Update(o * 2, l, mid, x, free);
+    } else {
+      Update(o * 2 + 1, mid + 1, r, x, free);
+    }
+    tree_[o] = Merge(tree_[o * 2], tree_[o * 2 + 1], mid + 1);
+  }
+
+  auto Query(int o, int l, int r, int ql, int qr) const -> Node {
+    if (ql <= l && r <= qr) {
+      return tree_[o];
+    }
+    int mid = (l + r) / 2;
+    if (qr <= mid) {
+      return Query(o * 2, l, mid, ql, qr);
+    }
+    if (ql > mid) {
+      return Query(o * 2 + 1, mid + 1, r, ql, qr);
+    }
+    return Merge(Query(o * 2, l, mid, ql, qr),
+                 Query(o * 2 + 1, mid + 1, r, ql, qr), mid + 1);
+  }
+
+  // 从右到左找，整段空闲的子树直接跳过
+  auto PrevUsed(int o, int l, int r, int pos) const -> int {
+    if (l > pos || tree_[o].pre_ == tree_[o].len_) {
+      return -1;
+    }
+    if (l == r) {
+      return l;
+    }
+    int mid = (l + r) / 2;
+    int res = PrevUsed(o * 2 + 1, mid + 1, r, pos);
+    return res != -1 ? res : PrevUsed(o * 2, l, mid, pos);
+  }
+
+  // 从左到右找，carry 是紧挨在 l 之前、起点不小于 addr 的空闲段长度
+  auto FirstFit(int o, int l, int r, int addr, int len, int &carry) const
+      -> int {
+    if (r < addr) {
+      return -1;
+    }
+    const Node &t = tree_[o];
+    if (l >= addr) {
+      if (carry + t.pre_ >= len) {
+        return l - carry; // 接上前面的空闲段就够了
+      }
+      if (t.best_ < len) {
+        carry = t.pre_ == t.len_ ? carry + t.len_ : t.suf_;
+        return -1; // 整个区间内都放不下
+      }
+    }
+    int mid = (l + r) / 2;
+    int res = FirstFit(o * 2, l, mid, addr, len, carry);
+    if (res != -1) {
+      return res;
+    }
+    return FirstFit(o * 2 + 1, mid + 1, r, addr, len, carry);
+  }
+
+  int v_;                   // 磁盘容量
+  LevelBitset free_;        // 空闲块
+  std::vector<Node> tree_;  // 空闲段线段树
+};
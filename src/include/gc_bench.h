@@ -0,0 +1,146 @@
+#pragma once
+
+#include "config.h"
+#include "disk_manager.h"
+#include "object.h"
+#include "printer.h"
+#include "scheduler.h"
+#include "top_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#ifndef _TIMESLICE
+#define _TIMESLICE
+extern int timeslice; // 全局变量，表示时间片
+#endif
+
+// 垃圾回收策略的基准：同样的写入、删除序列下比较 greedy 和 planned
+// 之后读取主副本的代价。定义 GC_BENCH 后程序启动时运行，结果输出到 stderr
+// 写入时选磁盘的随机数生成器是静态的，两种策略的副本分布不完全相同
+namespace bench {
+
+// 读完主副本的令牌数：磁头按地址顺序经过副本的块，连续读的费用按 0.8
+// 递减到 16，中间的空隙用 pass 走过，之后的读重新从 64 计费
+auto ReadCost(const Object &object) -> long long {
+  auto blocks = object.tdisk_[0];
+  std::sort(blocks.begin(), blocks.end());
+  long long cost = 64;
+  int prev = 64;
+  for (int j = 1; j < object.size_; j++) {
+    int gap = blocks[j] - blocks[j - 1] - 1;
+    if (gap == 0) {
+      prev = std::max(16, (prev * 4 + 4) / 5); // 向上取整的 0.8 倍
+    } else {
+      cost += gap;
+      prev = 64;
+    }
+    cost += prev;
+  }
+  return cost;
+}
+
+struct GCResult {
+  db read_cost_; // 每个存活对象读主副本的平均令牌数
+  db sweep_;     // 各段从段首到最后一个被占用的块的长度之和，按轮平均
+  db moves_;     // 每轮实际用掉的移动次数
+  long long ns_; // 垃圾回收的总耗时
+};
+
+// 跑 windows 轮：每轮写入、删除一批对象后做一次垃圾回收，
+// 之后统计存活对象的读取代价和段的扫描范围
+auto RunGC(config::GCPOLICIES policy, int windows) -> GCResult {
+  constexpr int M = 8;
+  constexpr int N = 10;
+  constexpr int V = 6000;
+  constexpr int K = 40;
+  constexpr int WRITES = 1200; // 每轮写入的对象数
+  constexpr db DROP = 0.2;     // 每轮每个存活对象被删除的概率
+  config::REAL_DISK_CNT = N;
+  config::RTQ_DISK_PART_SIZE = V / M;
+  config::JUMP_THRESHOLD = config::RTQ_DISK_PART_SIZE;
+
+  // 每个标签在每个磁盘的两个磁头区域各分一段，合起来占磁盘的 1/3
+  std::vector<std::vector<int>> solution(M, std::vector<int>(N + N, V / 6 / M));
+  std::vector<std::vector<int>> tsp(N + N, std::vector<int>(M));
+  for (auto &order : tsp) {
+    std::iota(order.begin(), order.end(), 0);
+  }
+  std::vector<std::vector<db>> alpha(M, std::vector<db>(M));
+  for (int i = 0; i < M; i++) {
+    for (int j = 0; j < M; j++) {
+      alpha[i][j] = i == j ? 1 : 0.5 / (1 + std::abs(i - j));
+    }
+  }
+  int total = windows * WRITES;
+  ObjectPool pool(total);
+  Scheduler sched(&pool, N, total, V);
+  SegmentManager seg_mgr(M, N, V, solution, tsp);
+  DiskManager dm(&pool, &sched, &seg_mgr, alpha, N, M, V, 0, K);
+  TopScheduler tes(&sched, &pool, &dm, V);
+
+  std::mt19937 rng(config::RANDOM_SEED);
+  std::discrete_distribution<int> tag_dist({1, 2, 3, 4, 5, 6, 7, 8});
+  std::uniform_int_distribution<int> size_dist(1, config::MAX_OBJECT_SIZE);
+  std::uniform_real_distribution<db> unit(0, 1);
+  std::vector<int> live;
+  GCResult res{0, 0, 0, 0};
+  long long samples = 0;
+  for (int w = 1; w <= windows; w++) {
+    timeslice = w * config::TIME_SLICE_DIVISOR;
+    std::vector<int> keep;
+    for (int oid : live) {
+      if (unit(rng) < DROP) {
+        tes.DeleteRequest(oid);
+      } else {
+        keep.push_back(oid);
+      }
+    }
+    live.swap(keep);
+    for (int i = 0; i < WRITES; i++) {
+      int oid = pool.GetSize();
+      tes.InsertRequest(oid, size_dist(rng), tag_dist(rng));
+      live.push_back(oid);
+    }
+    auto start = std::chrono::steady_clock::now();
+    dm.GarbageCollection(K, policy);
+    res.ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+    for (int d = 0; d < N; d++) {
+      res.moves_ += printer::gc_top[d];
+    }
+    printer::Clean(printer::GC);
+    for (int oid : live) {
+      res.read_cost_ += ReadCost(*pool.GetObjAt(oid));
+    }
+    samples += live.size();
+    for (auto &seg_list : seg_mgr.segs_) {
+      for (auto &seg : seg_list) {
+        res.sweep_ += seg.tail_ - seg.disk_addr_;
+      }
+    }
+  }
+  res.read_cost_ /= std::max(1LL, samples);
+  res.sweep_ /= windows;
+  res.moves_ /= windows;
+  return res;
+}
+
+void GCBench() {
+  constexpr int WINDOWS = 30;
+  for (auto policy : {config::GCPOLICIES::greedy, config::GCPOLICIES::planned}) {
+    auto res = RunGC(policy, WINDOWS);
+    std::cerr << "gc policy="
+              << (policy == config::GCPOLICIES::greedy ? "greedy" : "planned")
+              << " read_cost=" << res.read_cost_ << " sweep=" << res.sweep_
+              << " moves=" << res.moves_
+              << " gc_ms=" << static_cast<db>(res.ns_) / 1e6 << '\n';
+  }
+}
+
+} // namespace bench
@@ -0,0 +1,184 @@
+#pragma once
+#include "config.h"
+#include "deadline.h"
+#include "resource_allocator.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// 遗传算法资源分配器（岛屿模型）
+// 种群平均分到若干个岛，每个岛一个线程独立进化，适应度也在各自线程内计算；
+// 每 GA_MIGRATE_INTERVAL 代按环形把每个岛最好的 GA_MIGRANTS 个个体复制到
+// 下一个岛，替换那里最差的个体
+// 交叉按容器整列继承父母，再在列内挪动资源修复每种资源的总量；变异是和退火
+// 相同的四格交换。两种操作都保证每个容器恰好装满 v、每种资源总量为 r
+class GeneticOptimizer : public AllocationProblem {
+private:
+  struct Individual {
+    std::vector<int> x_; // 分配方案，按容器连续存放
+    db penalty_;         // 惩罚值，越小越好
+  };
+
+  struct Island {
+    std::mt19937 rng_;             // 岛内随机数生成器
+    std::vector<Individual> pop_;  // 种群，按惩罚值升序
+  };
+
+  // **锦标赛选择**
+  auto Select(Island &island) const -> const Individual & {
+    std::uniform_int_distribution<int> dist(0, island.pop_.size() - 1);
+    const auto &a = island.pop_[dist(island.rng_)];
+    const auto &b = island.pop_[dist(island.rng_)];
+    return a.penalty_ < b.penalty_ ? a : b;
+  }
+
+  // **交叉**：每个容器随机继承父母之一的整列，再修复每种资源的总量
+  auto Crossover(const Individual &a, const Individual &b,
+                 std::mt19937 &rng) const -> std::vector<int> {
+    std::vector<int> x = a.x_;
+    for (int j = 0; j < n_; ++j) {
+      if ((rng() & 1) != 0U) {
+        std::copy(b.x_.begin() + j * m_, b.x_.begin() + (j + 1) * m_,
+                  x.begin() + j * m_);
+      }
+    }
+    // 每个容器的和仍为 v，只需在列内把多的资源换成少的资源
+    RepairRows(x, std::uniform_int_distribution<int>(0, n_ - 1)(rng));
+    return x;
+  }
+
+  // **变异**：每个容器以 K_MUTATE_RATE 的概率和随机容器做一次四格交换
+  void Mutate(std::vector<int> &x, std::mt19937 &rng) const {
+    std::uniform_int_distribution<int> dist_n(0, n_ - 1);
+    std::uniform_int_distribution<int> dist_m(0, m_ - 1);
+    std::uniform_real_distribution<db> dist_p(0.0, 1.0);
+    for (int j1 = 0; j1 < n_; ++j1) {
+      if (dist_p(rng) >= config::K_MUTATE_RATE) {
+        continue;
+      }
+      int j2 = dist_n(rng);
+      int i1 = dist_m(rng);
+      int i2 = dist_m(rng);
+      int delta = std::uniform_int_distribution<int>(
+          0, std::min(x[j1 * m_ + i2], x[j2 * m_ + i1]))(rng);
+      x[j1 * m_ + i1] += delta;
+      x[j1 * m_ + i2] -= delta;
+      x[j2 * m_ + i2] += delta;
+      x[j2 * m_ + i1] -= delta;
+    }
+  }
+
+  // **岛内进化 gens 代**
+  void Evolve(Island &island, int gens) const {
+    int size = island.pop_.size();
+    int elite = std::min(config::ELITE_NUM, size);
+    std::uniform_real_distribution<db> dist_p(0.0, 1.0);
+    std::vector<Individual> next;
+    next.reserve(size);
+    for (int gen = 0; gen < gens && !deadline::Expired(); ++gen) {
+      next.assign(island.pop_.begin(), island.pop_.begin() + elite);
+      while (static_cast<int>(next.size()) < size) {
+        const auto &a = Select(island);
+        const auto &b = Select(island);
+        auto x = dist_p(island.rng_) < config::K_CROSS_RATE
+                     ? Crossover(a, b, island.rng_)
+                     : a.x_;
+        Mutate(x, island.rng_);
+        db penalty = ComputePenalty(x);
+        next.push_back({std::move(x), penalty});
+      }
+      std::swap(island.pop_, next);
+      SortPopulation(island);
+    }
+  }
+
+  static void SortPopulation(Island &island) {
+    std::stable_sort(island.pop_.begin(), island.pop_.end(),
+                     [](const Individual &a, const Individual &b) {
+                       return a.penalty_ < b.penalty_;
+                     });
+  }
+
+  // **环形迁移**：岛 k 最好的个体替换岛 k + 1 最差的个体
+  void Migrate() {
+    int cnt = islands_.size();
+    if (cnt < 2) {
+      return;
+    }
+    std::vector<std::vector<Individual>> migrants(cnt);
+    for (int k = 0; k < cnt; ++k) {
+      int num = std::min<int>(config::GA_MIGRANTS, islands_[k].pop_.size());
+      migrants[k].assign(islands_[k].pop_.begin(),
+                         islands_[k].pop_.begin() + num);
+    }
+    for (int k = 0; k < cnt; ++k) {
+      auto &pop = islands_[(k + 1) % cnt].pop_;
+      std::copy(migrants[k].begin(), migrants[k].end(),
+                pop.end() - migrants[k].size());
+      SortPopulation(islands_[(k + 1) % cnt]);
+    }
+  }
+
+  // 所有岛中最好的个体
+  auto Best() const -> const Individual & {
+    const Individual *best = &islands_[0].pop_[0];
+    for (const auto &island : islands_) {
+      if (island.pop_[0].penalty_ < best->penalty_) {
+        best = &island.pop_[0];
+      }
+    }
+    return *best;
+  }
+
+  std::vector<Island> islands_; // 各个岛
+
+public:
+  // **构造函数**
+  GeneticOptimizer(int m, int n, int v, int l, const std::vector<int> &r,
+                   const std::vector<std::vector<db>> &alpha,
+                   db beta = config::BETA_VALUE, db gama = config::GAMA_VALUE,
+                   int islands = config::GA_ISLANDS,
+                   unsigned seed = config::RANDOM_SEED)
+      : AllocationProblem(m, n, v, l, r, alpha, beta, gama),
+        islands_(std::max(1, islands)) {
+    for (int k = 0; k < static_cast<int>(islands_.size()); k++) {
+      islands_[k].rng_.seed(seed + k);
+    }
+  }
+
+  // **执行遗传算法优化**
+  auto Solve(bool iscerr = false, int maxGen = config::K_MAX_GEN,
+             int popSize = config::K_POP_SIZE) -> void {
+    int cnt = islands_.size();
+    int size = std::max(config::ELITE_NUM + 2, popSize / cnt);
+    [[maybe_unused]] auto start = std::chrono::steady_clock::now();
+    ParallelFor(cnt, [&](int k) {
+      auto &island = islands_[k];
+      island.pop_.clear();
+      for (int i = 0; i < size; i++) {
+        auto x = Flatten(InitializeSolution(island.rng_));
+        db penalty = ComputePenalty(x);
+        island.pop_.push_back({std::move(x), penalty});
+      }
+      SortPopulation(island);
+    });
+    for (int gen = 0; gen < maxGen && !deadline::Expired();
+         gen += config::GA_MIGRATE_INTERVAL) {
+      int gens = std::min(config::GA_MIGRATE_INTERVAL, maxGen - gen);
+      ParallelFor(cnt, [&](int k) { Evolve(islands_[k], gens); });
+      Migrate();
+#ifdef ISCERR
+      // 质量-时间曲线：代数、耗时（毫秒）、当前最优惩罚值
+      std::cerr << "gen=" << gen + gens << " ms="
+                << std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count()
+                << " penalty=" << Best().penalty_ << '\n';
+#endif
+    }
+    best_x_ = Unflatten(Best().x_);
+    best_penalty_ = Best().penalty_;
+  }
+};
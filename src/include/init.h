@@ -1,90 +1,65 @@
 #pragma once
 
+#include "alloc_cache.h"
 #include "config.h"
+#include "correlation.h"
 #include "data.h"
+#include "deadline.h"
+#include "flow_allocator.h"
+#include "genetic_allocator.h"
 #include "resource_allocator.h"
 #include "tsp.h"
 #include <iostream>
 #include <numeric>
+#include <tuple>
 #include <vector>
 
-struct Spearman {
-  // 结构体用于存储值及其原始索引
-  struct RankData {
-    db value;  // NOLINT
-    int index; // NOLINT
-  };
+static constexpr int TIME_SLICE_DIVISOR =
+    config::TIME_SLICE_DIVISOR; // 常量替代魔法数字
 
-  // 比较函数用于排序
-  static auto compare(RankData a, RankData b) -> bool { // NOLINT
-    return a.value < b.value;
+// 按 config::ALLOCATOR 选择的算法求解资源分配
+// 给了热启动解时，不论选择哪种算法，都从它出发做一次短的低温退火，
+// 至多 max_iter 次迭代
+auto SolveAllocation(int m, int n, int v, int l, const std::vector<int> &r,
+                     const std::vector<std::vector<db>> &alpha,
+                     const std::vector<std::vector<int>> *warm = nullptr,
+                     int max_iter = config::MAX_ITER)
+    -> std::vector<std::vector<int>> {
+  if (warm != nullptr) {
+    ResourceAllocator ra(m, n, v, l, r, alpha);
+    ra.WarmStart(*warm);
+    ra.Solve(false, config::WARM_T, config::WARM_COOLING_RATE, max_iter);
+    return ra.GetBestSolution();
   }
-
-  // 计算秩
-  auto getRanks(const std::vector<db> &data) -> std::vector<db> { // NOLINT
-    int n = data.size();
-    std::vector<RankData> rankData(n); // NOLINT
-
-    // 记录原始值和索引
-    for (int i = 0; i < n; i++) {
-      rankData[i] = {data[i], i};
-    }
-
-    // 按值排序
-    sort(rankData.begin(), rankData.end(), compare); // NOLINT
-
-    // 计算秩
-    std::vector<db> ranks(n);
-    int i = 0;
-    while (i < n) {
-      int j = i;
-      db sumRank = 0.0; // NOLINT
-      while (j < n && rankData[j].value == rankData[i].value) {
-        sumRank += (j + 1); // 1-based rank
-        j++;
-      }
-      db avgRank = sumRank / (j - i); // NOLINT
-      for (int k = i; k < j; k++) {
-        ranks[rankData[k].index] = avgRank;
-      }
-      i = j;
-    }
-
-    return ranks;
+#ifdef CHECK_ALLOCATOR
+  if constexpr (config::ALLOCATOR != config::ALLOCATORS::anneal) {
+    ResourceAllocator ra(m, n, v, l, r, alpha);
+    ra.Solve();
+    std::cerr << "anneal penalty: " << ra.GetBestPenalty() << '\n';
   }
-
-  // 计算斯皮尔曼秩相关系数
-  auto SpearmanCorrelation(const std::vector<db> &x,
-                           const std::vector<db> &y) -> db { // NOLINT
-    int n = x.size();
-    if (n != y.size() || n == 0) {
-      std::cerr << "Error: Input vectors must have the same non-zero size.\n";
-      return NAN;
-    }
-
-    // 计算秩
-    std::vector<db> rankX = getRanks(x); // NOLINT
-    std::vector<db> rankY = getRanks(y); // NOLINT
-
-    // 计算秩差的平方和
-    db dSquaredSum = 0.0; // NOLINT
-    for (int i = 0; i < n; i++) {
-      db d = rankX[i] - rankY[i];
-      dSquaredSum += d * d;
-    }
-
-    // 计算斯皮尔曼相关系数
-    db spearman =
-        1.0 - (6.0 * dSquaredSum) / std::max(1, (n * (n * n - 1))); // NOLINT
-    return spearman;
+#endif
+  if constexpr (config::ALLOCATOR == config::ALLOCATORS::genetic) {
+    GeneticOptimizer ga(m, n, v, l, r, alpha);
+    ga.Solve();
+    return ga.GetBestSolution();
   }
-};
-static constexpr int TIME_SLICE_DIVISOR =
-    config::TIME_SLICE_DIVISOR; // 常量替代魔法数字
+  if constexpr (config::ALLOCATOR == config::ALLOCATORS::flow) {
+    FlowOptimizer fo(m, n, v, l, r, alpha);
+    fo.Solve();
+    return fo.GetBestSolution();
+  }
+  ResourceAllocator ra(m, n, v, l, r, alpha);
+  ra.Solve();
+  return ra.GetBestSolution();
+}
 
+// from: 只考虑第 from 个时间片分组及之后的占用高峰（在线重新分配时用）
+// max_iter: 热启动退火的迭代次数上限
 auto InitResourceAllocator(int t, int m, int n, int v, int g,
                            const Data &delete_data, const Data &write_data,
-                           const Data &read_data)
+                           const Data &read_data,
+                           const std::vector<std::vector<int>> *warm = nullptr,
+                           int from = 0, int max_iter = config::MAX_ITER)
     -> std::pair<std::vector<std::vector<int>>, std::vector<std::vector<db>>> {
   // 初始化时间片数据
   std::vector<std::vector<int>> timeslice_data(
@@ -113,17 +88,21 @@ auto InitResourceAllocator(int t, int m, int n, int v, int g,
     for (int j = 1; j < (t - 1) / TIME_SLICE_DIVISOR + 1; j++) {
       timeslice_data[i][j] += timeslice_data[i][j - 1]; // 累积和
     }
-    max_allocate[i] = *std::max_element(timeslice_data[i].begin(),
-                                        timeslice_data[i].end()); // 最大分配值
+    max_allocate[i] = *std::max_element(
+        timeslice_data[i].begin() +
+            std::min<int>(from, timeslice_data[i].size() - 1),
+        timeslice_data[i].end()); // 最大分配值
   }
+  // 所有标签都没有数据时按 1 计，避免除零
+  int total = std::max(1, std::accumulate(max_allocate.begin(),
+                                          max_allocate.end(), 0));
 
   // 计算资源分配
   if constexpr (config::WritePolicy() == config::compact) {
     for (int i = 0; i < m; i++) {
       if (i < m - 1) {
         resource[i] = max_allocate[i] * (2 * n * (v / 6)) /
-                      std::accumulate(max_allocate.begin(), max_allocate.end(),
-                                      0); // 按比例分配资源
+                      total; // 按比例分配资源
       } else {
         resource[i] =
             2 * n * (v / 6) - std::accumulate(resource.begin(), resource.end(),
@@ -133,9 +112,7 @@ auto InitResourceAllocator(int t, int m, int n, int v, int g,
   } else {
     for (int i = 0; i < m; i++) {
       if (i < m - 1) {
-        resource[i] = max_allocate[i] * (n * v) /
-                      std::accumulate(max_allocate.begin(), max_allocate.end(),
-                                      0); // 按比例分配资源
+        resource[i] = max_allocate[i] * (n * v) / total; // 按比例分配资源
       } else {
         resource[i] = n * (v)-std::accumulate(resource.begin(), resource.end(),
                                               0); // 剩余资源分配给最后一个标签
@@ -143,24 +120,27 @@ auto InitResourceAllocator(int t, int m, int n, int v, int g,
     }
   }
 
-  // 计算 alpha 矩阵
-  for (int i = 0; i < m; i++) {
-    for (int j = 0; j < m; j++) {
-      std::vector<db> read_data_i(read_data[i].size());
-      std::vector<db> read_data_j(read_data[j].size());
-      for (int t = 0; t < read_data_i.size(); t++) {
-        read_data_i[t] = read_data[i][t];
-        read_data_j[t] = read_data[j][t];
+  // 计算 alpha 矩阵：读取序列的斯皮尔曼秩相关
+  CorrelationEngine corr(read_data);
+  alpha = corr.Spearman();
+  // 高峰前后相继的标签放在一起不会同时争抢磁头：分配时降低它们的混合惩罚，
+  // TSP 和写入时提高它们的相似度
+  std::vector<std::vector<db>> alloc_alpha = alpha;
+  if constexpr (config::LAG_WEIGHT != 0) {
+    auto lag = corr.LaggedMatrix(config::CORRELATION_MAX_LAG);
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < m; j++) {
+        alloc_alpha[i][j] -= config::LAG_WEIGHT * lag[i][j];
+        alpha[i][j] += config::LAG_WEIGHT * lag[i][j];
       }
-      alpha[i][j] = Spearman().SpearmanCorrelation(read_data_i, read_data_j);
     }
   }
 
   // 初始化资源分配器并求解
   if constexpr (config::WritePolicy() == config::compact) {
-    ResourceAllocator ra(m, 2*n, v / 6, 4 * g / 3, resource, alpha);
-    ra.Solve();
-    auto sol = ra.GetBestSolution();
+    auto sol =
+        SolveAllocation(m, 2 * n, v / 6, 4 * g / 3, resource, alloc_alpha,
+                        warm, max_iter);
     // for (auto &x : sol) {
     //   for (int i = 0; i < n; i++) {
     //     x[i] /= 2;
@@ -169,9 +149,8 @@ auto InitResourceAllocator(int t, int m, int n, int v, int g,
     // }
     return {sol, alpha};
   }
-  ResourceAllocator ra(m, n, v, g, resource, alpha);
-  ra.Solve();
-  return {ra.GetBestSolution(), alpha};
+  return {SolveAllocation(m, n, v, g, resource, alloc_alpha, warm, max_iter),
+          alpha};
 }
 
 auto InitTSP(int n, int m, const std::vector<std::vector<db>> &alpha,
@@ -179,22 +158,28 @@ auto InitTSP(int n, int m, const std::vector<std::vector<db>> &alpha,
     -> std::vector<std::vector<int>> {
   std::vector<std::vector<int>> ans;
 #ifdef USINGTSP
-  for (int _ = 0; _ < 2 * n; _++) {
-    std::vector<std::vector<db>> dist(m, std::vector<db>(m, 0));
-    for (int i = 0; i < m; i++) {
-      for (int j = 0; j < m; j++) {
-        dist[i][j] = alpha[i][j] * solution[i][_] * solution[j][_];
+  ans.resize(2 * n);
+  // 2n 个磁头区域互不相关，分给 TSP_THREADS 个线程交错求解
+  int threads = std::min(config::TSP_THREADS, 2 * n);
+  ParallelFor(threads, [&](int k) {
+    for (int _ = k; _ < 2 * n; _ += threads) {
+      std::vector<std::vector<db>> dist(m, std::vector<db>(m, 0));
+      for (int i = 0; i < m; i++) {
+        for (int j = 0; j < m; j++) {
+          dist[i][j] = alpha[i][j] * solution[i][_] * solution[j][_];
+        }
       }
+      ans[_] = TSP(m, dist);
     }
-    auto tsp = TSP(m, dist);
+  });
 #ifdef ISCERR
+  for (const auto &tsp : ans) {
     for (auto x : tsp) {
       std::cerr << x << ' ';
     }
     std::cerr << '\n';
-#endif
-    ans.push_back(tsp);
   }
+#endif
   return ans;
 #else
   std::vector<int> tmp(m);
@@ -203,4 +188,55 @@ auto InitTSP(int n, int m, const std::vector<std::vector<db>> &alpha,
   return ans;
 #endif
 }
-// 1012
\ No newline at end of file
+// 初始化：资源分配 + TSP
+// 定义了 USE_ALLOC_CACHE 时先查本地缓存，完全命中直接返回缓存的结果，
+// 相近的条目用来热启动退火，求解完成后把结果写回缓存
+// 返回值：{分配方案, alpha, TSP 顺序}
+auto Initialize(int t, int m, int n, int v, int g, [[maybe_unused]] int k,
+                const Data &delete_data, const Data &write_data,
+                const Data &read_data)
+    -> std::tuple<std::vector<std::vector<int>>, std::vector<std::vector<db>>,
+                  std::vector<std::vector<int>>> {
+  const std::vector<std::vector<int>> *warm = nullptr;
+  [[maybe_unused]] const char *cache_state = "off";
+#ifdef USE_ALLOC_CACHE
+  std::vector<int> header = {t, m, n, v, g, k};
+  std::vector<int> hist;
+  for (const Data *data : {&delete_data, &write_data, &read_data}) {
+    for (const auto &row : data->vec) {
+      hist.insert(hist.end(), row.begin(), row.end());
+    }
+  }
+  auto entries = alloc_cache::Load();
+  auto match = alloc_cache::Find(entries, header, hist);
+  cache_state = "miss";
+  if (match.entry_ != nullptr && match.exact_) {
+#ifdef ISCERR
+    std::cerr << "init: cache=hit total=" << deadline::ElapsedMs() << "ms\n";
+#endif
+    return {match.entry_->solution_, match.entry_->alpha_,
+            match.entry_->tsp_};
+  }
+  if (match.entry_ != nullptr) {
+    warm = &match.entry_->solution_;
+    cache_state = "warm";
+  }
+#endif
+  auto [solution, alpha] = InitResourceAllocator(
+      t, m, n, v, g, delete_data, write_data, read_data, warm);
+  [[maybe_unused]] auto allocator_ms = deadline::ElapsedMs();
+  auto tsp = InitTSP(n, m, alpha, solution);
+#ifdef ISCERR
+  std::cerr << "init: cache=" << cache_state << " allocator=" << allocator_ms
+            << "ms tsp=" << deadline::ElapsedMs() - allocator_ms
+            << "ms budget=" << config::INIT_TIME_BUDGET_MS << "ms\n";
+#endif
+#ifdef USE_ALLOC_CACHE
+  uint64_t key = alloc_cache::Fingerprint(header, hist);
+  entries.push_back({key, std::move(header), std::move(hist), solution, alpha,
+                     tsp});
+  alloc_cache::Save(entries);
+#endif
+  return {solution, alpha, tsp};
+}
+// 1012
@@ -18,7 +18,8 @@ struct Object {
   // - id: 对象的唯一标识符
   // - tag: 对象的标签，用于分类
   // - size: 对象的大小（块数）
-  Object(int id, int tag, int size) : id_(id), tag_(tag), size_(size) {
+  Object(int id, int tag, int size)
+      : id_(id), tag_(tag), size_(size), birth_(timeslice) {
     for (auto &i : tdisk_) {
       i.resize(size_, {}); // 初始化每个副本的块信息
     }
@@ -29,6 +30,7 @@ struct Object {
   int id_;     // 对象的唯一标识符
   int tag_;    // 对象的标签
   int size_;   // 对象的大小（块数）
+  int birth_;  // 写入的时间片
   std::array<int, 3> idisk_; // 存储对象的副本所在的磁盘 ID（最多 3 个副本）
   std::vector<int> tdisk_[3]; // 每个副本的块信息（块 ID 列表）
 };
@@ -68,6 +70,9 @@ public:
   // 返回值：布尔值，表示对象是否有效
   auto IsValid(int oid) -> bool { return objs_[oid]->valid_; }
 
+  // 对象总数（包括已删除的），对象按写入顺序编号
+  auto GetSize() const -> int { return size_; }
+
   // 将对象标记为无效
   // 参数：
   // - oid: 对象的索引
@@ -3,9 +3,17 @@
 #ifndef _PRINTER_H
 #define _PRINTER_H
 #include "object.h"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
-#include <string>
+#include <utility>
+#include <vector>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #ifndef _TIMESLICE
 #define _TIMESLICE
@@ -19,10 +27,82 @@ int buf[4]
        [config::PRINTER_BUF_CAPACITY]; // 三种请求类型的缓冲区，每种类型最多存储
                                        // 2^20 个请求
 int top[4] = {0};
-std::string ops[config::MAX_N][2]; // 每个磁盘的操作记录（最多支持 10 个磁盘）
+// 每个磁头的操作记录，按 {字符, 连续次数} 存成段（最多支持 10 个磁盘）
+std::vector<std::pair<char, int>> ops[config::MAX_N][2];
+int jump[config::MAX_N][2] = {}; // 每个磁头的跳转目标（从 1 开始），0 表示不跳转
 int gc_top[config::MAX_N] = {0}; // 垃圾回收操作的索引
 int gc_buf[config::MAX_N][config::PRINTER_BUF_CAPACITY][2];
 
+// 输出缓冲区，一个时间片的输出全部写到这里，最后一次性写出
+char out[config::PRINTER_OUT_CAPACITY];
+int out_top = 0;
+
+// 把输出缓冲区写到 stdout
+void Flush() {
+  int pos = 0;
+  while (pos < out_top) {
+#if defined(_WIN32)
+    int len = _write(1, out + pos, out_top - pos);
+#else
+    auto len = write(1, out + pos, out_top - pos);
+#endif
+    if (len <= 0) {
+      break;
+    }
+    pos += len;
+  }
+  out_top = 0;
+}
+
+// 确保输出缓冲区还能放下 len 个字节，放不下就先写出
+inline void Reserve(int len) {
+  if (out_top + len > config::PRINTER_OUT_CAPACITY) {
+    Flush();
+  }
+}
+
+inline void PutChar(char c) {
+  Reserve(1);
+  out[out_top++] = c;
+}
+
+// 连续输出 cnt 个字符 c
+inline void PutRun(char c, int cnt) {
+  while (cnt > 0) {
+    Reserve(1);
+    int len = std::min(cnt, config::PRINTER_OUT_CAPACITY - out_top);
+    std::memset(out + out_top, c, len);
+    out_top += len;
+    cnt -= len;
+  }
+}
+
+inline void PutStr(const char *str) {
+  int len = static_cast<int>(std::strlen(str));
+  Reserve(len);
+  std::memcpy(out + out_top, str, len);
+  out_top += len;
+}
+
+// 输出一个整数，后面跟上分隔符 sep
+inline void PutInt(int x, char sep) {
+  Reserve(12);
+  if (x < 0) {
+    out[out_top++] = '-';
+    x = -x;
+  }
+  char tmp[10];
+  int len = 0;
+  do {
+    tmp[len++] = static_cast<char>('0' + x % 10);
+    x /= 10;
+  } while (x > 0);
+  while (len > 0) {
+    out[out_top++] = tmp[--len];
+  }
+  out[out_top++] = sep;
+}
+
 // 请求类型的枚举
 // DELETE: 删除请求
 // WRITE: 写入请求
@@ -34,7 +114,6 @@ enum { DELETE = 0, WRITE, READ, READBUSY, GC };
 // 参数：
 // - idx: 要清空的缓冲区索引
 void Clean(int idx) {
-  std::cout.flush(); // 刷新输出流
   if (idx == GC) {
     for (int &i : gc_top) {
       i = 0; // 重置垃圾回收操作的索引
@@ -42,9 +121,26 @@ void Clean(int idx) {
     return;
   }
   top[idx] = 0; // 重置缓冲区大小
-  for (auto &op : ops) {
-    op[0].clear(); // 清空操作记录
-    op[1].clear(); // 清空操作记录
+  for (int i = 0; i < config::MAX_N; i++) {
+    for (int j = 0; j < 2; j++) {
+      ops[i][j].clear(); // 清空操作记录
+      jump[i][j] = 0;
+    }
+  }
+}
+
+// 往磁头的操作记录末尾追加 cnt 个字符 c，和上一段相同就合并
+void AddRun(int DiskNum, char c, int cnt) {
+  if (cnt <= 0) {
+    return;
+  }
+  int diskhead = static_cast<int>(DiskNum >= config::REAL_DISK_CNT);
+  DiskNum -= DiskNum >= config::REAL_DISK_CNT ? config::REAL_DISK_CNT : 0;
+  auto &op = ops[DiskNum][diskhead];
+  if (!op.empty() && op.back().first == c) {
+    op.back().second += cnt;
+  } else {
+    op.emplace_back(c, cnt);
   }
 }
 
@@ -58,11 +154,7 @@ void AddReadRequest(int RequestID) { buf[READ][top[READ]++] = RequestID; }
 // - DiskNum: 磁盘编号
 // - cnt: 跳过的次数
 void ReadAddPass(int DiskNum, int cnt) {
-  int diskhead = static_cast<int>(DiskNum >= config::REAL_DISK_CNT);
-  DiskNum -= DiskNum >= config::REAL_DISK_CNT ? config::REAL_DISK_CNT : 0;
-  for (int i = 0; i < cnt; i++) {
-    ops[DiskNum][diskhead].push_back('p'); // 添加 'p' 表示跳过操作
-  }
+  AddRun(DiskNum, 'p', cnt); // 添加 'p' 表示跳过操作
 }
 
 // 添加读取操作到指定磁盘的操作记录
@@ -70,11 +162,7 @@ void ReadAddPass(int DiskNum, int cnt) {
 // - DiskNum: 磁盘编号
 // - cnt: 读取的次数
 void ReadAddRead(int DiskNum, int cnt) {
-  int diskhead = static_cast<int>(DiskNum >= config::REAL_DISK_CNT);
-  DiskNum -= DiskNum >= config::REAL_DISK_CNT ? config::REAL_DISK_CNT : 0;
-  for (int i = 0; i < cnt; i++) {
-    ops[DiskNum][diskhead].push_back('r'); // 添加 'r' 表示读取操作
-  }
+  AddRun(DiskNum, 'r', cnt); // 添加 'r' 表示读取操作
 }
 
 // 设置跳转操作到指定磁盘的操作记录
@@ -84,8 +172,8 @@ void ReadAddRead(int DiskNum, int cnt) {
 void ReadSetJump(int DiskNum, int DiskblockID) {
   int diskhead = static_cast<int>(DiskNum >= config::REAL_DISK_CNT);
   DiskNum -= DiskNum >= config::REAL_DISK_CNT ? config::REAL_DISK_CNT : 0;
-  ops[DiskNum][diskhead] =
-      "j " + std::to_string(DiskblockID + 1); // 添加跳转操作
+  ops[DiskNum][diskhead].clear();
+  jump[DiskNum][diskhead] = DiskblockID + 1; // 添加跳转操作
 }
 
 void ReadAddBusy(int RequestID) { buf[READBUSY][top[READBUSY]++] = RequestID; }
@@ -102,11 +190,17 @@ void AddDeletedRequest(int RequestID) {
   buf[DELETE][top[DELETE]++] = RequestID;
 }
 
+// 打印时间片同步信息
+auto PrintTimestamp() -> void {
+  PutStr("TIMESTAMP ");
+  PutInt(timeslice, '\n');
+}
+
 // 打印删除请求
 auto PrintDelete() -> void {
-  std::cout << top[DELETE] << '\n'; // 打印删除请求的数量
+  PutInt(top[DELETE], '\n'); // 打印删除请求的数量
   for (int i = 0; i < top[DELETE]; i++) {
-    std::cout << buf[DELETE][i] << '\n'; // 打印每个删除请求的 ID
+    PutInt(buf[DELETE][i], '\n'); // 打印每个删除请求的 ID
   }
   Clean(DELETE); // 清空删除请求缓冲区
 }
@@ -116,18 +210,18 @@ auto PrintDelete() -> void {
 // - obj_pool: 对象池，用于获取对象信息
 auto PrintWrite(ObjectPool &obj_pool) -> void {
   for (int i = 0; i < top[WRITE]; i++) {
-    std::cout << buf[WRITE][i] + 1 << '\n'; // 打印写入对象的 ID（从 1 开始）
+    PutInt(buf[WRITE][i] + 1, '\n'); // 打印写入对象的 ID（从 1 开始）
     auto obj = obj_pool.GetObjAt(buf[WRITE][i]); // 获取对象
     for (int j = 0; j < 3; j++) {                // 遍历对象的每个副本
-      std::cout << (obj->idisk_[j] >= config::REAL_DISK_CNT
-                        ? obj->idisk_[j] - config::REAL_DISK_CNT
-                        : obj->idisk_[j]) +
-                       1
-                << ' '; // 打印副本所在的磁盘编号
+      PutInt((obj->idisk_[j] >= config::REAL_DISK_CNT
+                  ? obj->idisk_[j] - config::REAL_DISK_CNT
+                  : obj->idisk_[j]) +
+                 1,
+             ' '); // 打印副本所在的磁盘编号
       for (auto it : obj->tdisk_[j]) {
-        std::cout << it + 1 << ' '; // 打印副本的块编号
+        PutInt(it + 1, ' '); // 打印副本的块编号
       }
-      std::cout << '\n';
+      PutChar('\n');
     }
   }
   Clean(WRITE); // 清空写入请求缓冲区
@@ -139,20 +233,24 @@ auto PrintWrite(ObjectPool &obj_pool) -> void {
 auto PrintRead(int N) -> void {
   for (int i = 0; i < N; i++) {
     for (int j = 0; j < 2; j++) {
-      auto &op = ops[i][j];
-      if (op.empty() || op.back() == 'r' || op.back() == 'p') {
-        op.push_back('#'); // 添加 '#' 表示操作结束
+      if (jump[i][j] > 0) {
+        PutStr("j ");
+        PutInt(jump[i][j], '\n'); // 打印跳转操作
+        continue;
+      }
+      for (const auto &[c, cnt] : ops[i][j]) {
+        PutRun(c, cnt); // 打印磁盘的操作记录
       }
-      std::cout << op << '\n'; // 打印磁盘的操作记录
+      PutStr("#\n"); // '#' 表示操作结束
     }
   }
-  std::cout << top[READ] << '\n'; // 打印读取请求的数量
+  PutInt(top[READ], '\n'); // 打印读取请求的数量
   for (int i = 0; i < top[READ]; i++) {
-    std::cout << buf[READ][i] << '\n'; // 打印每个读取请求的 ID
+    PutInt(buf[READ][i], '\n'); // 打印每个读取请求的 ID
   }
-  std::cout << top[READBUSY] << '\n'; // 打印读取请求的数量
+  PutInt(top[READBUSY], '\n'); // 打印读取请求的数量
   for (int i = 0; i < top[READBUSY]; i++) {
-    std::cout << buf[READBUSY][i] << '\n'; // 打印每个读取请求的 ID
+    PutInt(buf[READBUSY][i], '\n'); // 打印每个读取请求的 ID
   }
   Clean(READ);     // 清空读取请求缓冲区
   Clean(READBUSY); // 清空读取请求缓冲区
@@ -166,11 +264,12 @@ auto GCAdd(int disk_id, int id1, int id2) {
 }
 
 auto GCPrint(int N) {
-  std::cout << "GARBAGE COLLECTION\n";
+  PutStr("GARBAGE COLLECTION\n");
   for (int i = 0; i < N; i++) {
-    std::cout << gc_top[i] << '\n';
+    PutInt(gc_top[i], '\n');
     for (int j = 0; j < gc_top[i]; j++) {
-      std::cout << gc_buf[i][j][0] + 1 << ' ' << gc_buf[i][j][1] + 1 << '\n';
+      PutInt(gc_buf[i][j][0] + 1, ' ');
+      PutInt(gc_buf[i][j][1] + 1, '\n');
     }
   }
   Clean(GC); // 清空垃圾回收操作缓冲区
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "config.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 交互输入的解析层：整块读入 stdin（离线运行时直接 mmap 文件），
+// 手写整数解析，把每个时间片的删除/写入/读取请求解析成定长记录
+namespace reader {
+
+// 写入请求记录
+struct WriteCmd {
+  int id_;   // 对象 ID（1 开始）
+  int size_; // 对象大小（块数）
+  int tag_;  // 对象标签（1 开始）
+};
+
+// 读取请求记录
+struct ReadCmd {
+  int req_id_; // 读取请求 ID
+  int obj_id_; // 对象 ID（1 开始）
+};
+
+char buf[config::READER_BUF_CAPACITY]; // 管道输入的块缓冲区
+const char *cur = buf;                 // 当前解析位置
+const char *end = buf;                 // 有效数据末尾
+bool mapped = false;                   // 输入是否来自 mmap 的文件
+bool timing = false;                   // 是否处于计时的解析段内
+void (*flush_hook)() = nullptr;        // 阻塞等待输入前调用，先把输出写出去
+
+long long parse_bytes = 0; // 已解析的字节数
+long long parse_ns = 0;    // 解析耗时（不含等待交互器的时间）
+
+std::vector<int> delete_cmds;     // 当前时间片的删除对象 ID
+std::vector<WriteCmd> write_cmds; // 当前时间片的写入请求
+std::vector<ReadCmd> read_cmds;   // 当前时间片的读取请求
+
+// 初始化输入层，stdin 是普通文件时整体映射到内存
+void Init() {
+#if !defined(_WIN32)
+  struct stat st {};
+  if (fstat(0, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+    return;
+  }
+  off_t pos = lseek(0, 0, SEEK_CUR);
+  void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, 0, 0);
+  if (p == MAP_FAILED) {
+    return;
+  }
+  madvise(p, st.st_size, MADV_SEQUENTIAL);
+  cur = static_cast<const char *>(p) + (pos > 0 ? pos : 0);
+  end = static_cast<const char *>(p) + st.st_size;
+  parse_bytes = st.st_size - (pos > 0 ? pos : 0);
+  mapped = true;
+#endif
+}
+
+// 读入下一块数据，管道上 read 只返回已到达的部分，不会等缓冲区填满
+// 返回值：是否还有数据
+auto Refill() -> bool {
+  if (mapped) {
+    return false;
+  }
+  if (flush_hook != nullptr) {
+    flush_hook();
+  }
+  auto start = std::chrono::steady_clock::now();
+#if defined(_WIN32)
+  int len = _read(0, buf, config::READER_BUF_CAPACITY);
+#else
+  auto len = read(0, buf, config::READER_BUF_CAPACITY);
+#endif
+  // 等待交互器的时间不计入解析耗时
+  if (timing) {
+    parse_ns -= std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+  }
+  if (len <= 0) {
+    return false;
+  }
+  cur = buf;
+  end = buf + len;
+  parse_bytes += len;
+  return true;
+}
+
+// 读取一个字符，输入结束返回 EOF
+inline auto Getc() -> int {
+  if (cur == end && !Refill()) {
+    return EOF;
+  }
+  return static_cast<unsigned char>(*cur++);
+}
+
+// 解析下一个整数，跳过前导空白
+auto NextInt() -> int {
+  int c = Getc();
+  while (c != EOF && c != '-' && (c < '0' || c > '9')) {
+    c = Getc();
+  }
+  bool neg = (c == '-');
+  if (neg) {
+    c = Getc();
+  }
+  int x = 0;
+  while (c >= '0' && c <= '9') {
+    x = x * 10 + (c - '0');
+    c = Getc();
+  }
+  return neg ? -x : x;
+}
+
+// 跳过下一个单词（如 TIMESTAMP、GARBAGE、COLLECTION）
+void SkipToken() {
+  int c = Getc();
+  while (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+    c = Getc();
+  }
+  while (c != EOF && c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+    c = Getc();
+  }
+}
+
+// 计时辅助，统计一段解析的耗时
+struct ParseTimer {
+  std::chrono::steady_clock::time_point start_ =
+      std::chrono::steady_clock::now();
+  ParseTimer() { timing = true; }
+  ~ParseTimer() {
+    timing = false;
+    parse_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start_)
+                    .count();
+  }
+};
+
+// 解析 "TIMESTAMP x"
+// 返回值：时间片编号
+auto ParseTimestamp() -> int {
+  ParseTimer timer;
+  SkipToken();
+  return NextInt();
+}
+
+// 解析删除请求
+auto ParseDelete() -> const std::vector<int> & {
+  ParseTimer timer;
+  delete_cmds.resize(NextInt());
+  for (auto &id : delete_cmds) {
+    id = NextInt();
+  }
+  return delete_cmds;
+}
+
+// 解析写入请求
+auto ParseWrite() -> const std::vector<WriteCmd> & {
+  ParseTimer timer;
+  write_cmds.resize(NextInt());
+  for (auto &cmd : write_cmds) {
+    cmd.id_ = NextInt();
+    cmd.size_ = NextInt();
+    cmd.tag_ = NextInt();
+  }
+  return write_cmds;
+}
+
+// 解析读取请求
+auto ParseRead() -> const std::vector<ReadCmd> & {
+  ParseTimer timer;
+  read_cmds.resize(NextInt());
+  for (auto &cmd : read_cmds) {
+    cmd.req_id_ = NextInt();
+    cmd.obj_id_ = NextInt();
+  }
+  return read_cmds;
+}
+
+// 解析 "GARBAGE COLLECTION"
+void ParseGC() {
+  ParseTimer timer;
+  SkipToken();
+  SkipToken();
+}
+
+// 输出解析吞吐量
+void Report() {
+  std::cerr << "parse: " << parse_bytes << " bytes, " << parse_ns / 1000000
+            << " ms, "
+            << (parse_ns > 0 ? static_cast<db>(parse_bytes) * 1e3 / parse_ns : 0)
+            << " MB/s\n";
+}
+
+} // namespace reader
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+// 读取队列的热点区域索引
+// - 树状数组按块记录待读请求数，O(log V) 求任意区间 [a, b) 的请求数
+// - 磁盘按 width 个块分桶，窗口是从某个桶开始的连续 k 个桶（环形），
+//   线段树的第 j 个叶子是从桶 j 开始的窗口里的请求数，一个桶的变化是
+//   对 k 个窗口的区间加，根节点维护最大值和最左的位置，O(1) 得到最密的窗口
+class RegionIndex {
+public:
+  // 参数：
+  // - V: 磁盘容量（块数）
+  // - width: 桶宽
+  // - window: 窗口宽度（块数），向上取整到桶宽的倍数
+  RegionIndex(int V, int width, int window)
+      : v_(V), width_(std::max(1, width)), nb_((V + width_ - 1) / width_),
+        k_(std::clamp((window + width_ - 1) / width_, 1, nb_)), fen_(V + 1, 0),
+        mx_(4 * nb_, 0), pos_(4 * nb_, 0), lazy_(4 * nb_, 0) {
+    Build(1, 0, nb_ - 1);
+  }
+
+  // 块 x 的请求数变化 d
+  void Add(int x, int d) {
+    for (int i = x + 1; i <= v_; i += i & -i) {
+      fen_[i] += d;
+    }
+    // 包含桶 b 的窗口从 b - k + 1 到 b（环形）
+    int b = x / width_;
+    int l = b - k_ + 1;
+    if (l >= 0) {
+      RangeAdd(1, 0, nb_ - 1, l, b, d);
+    } else {
+      RangeAdd(1, 0, nb_ - 1, 0, b, d);
+      RangeAdd(1, 0, nb_ - 1, nb_ + l, nb_ - 1, d);
+    }
+  }
+
+  // 区间 [a, b) 内的请求数，a > b 时按环形处理
+  auto Weight(int a, int b) const -> int {
+    a = std::clamp(a, 0, v_);
+    b = std::clamp(b, 0, v_);
+    if (a > b) {
+      return Prefix(v_) - Prefix(a) + Prefix(b);
+    }
+    return Prefix(b) - Prefix(a);
+  }
+
+  // 从 pos 开始一个窗口宽度内的请求数（环形）
+  // 窗口覆盖全部桶时宽度可能超过 V，先截到 V，免得环形取差只剩一小段
+  auto WindowWeight(int pos) const -> int {
+    if (GetWindow() == v_) {
+      return Prefix(v_); // 整个磁盘
+    }
+    int end = pos + GetWindow();
+    return end <= v_ ? Weight(pos, end) : Weight(pos, end - v_);
+  }
+
+  // 最密的窗口
+  // 返回值：{窗口起点（块编号）, 窗口内的请求数}
+  auto Densest() const -> std::pair<int, int> {
+    return {pos_[1] * width_, mx_[1]};
+  }
+
+  auto GetWindow() const -> int { return std::min(k_ * width_, v_); }
+
+private:
+  auto Prefix(int x) const -> int {
+    int sum = 0;
+    for (int i = x; i > 0; i -= i & -i) {
+      sum += fen_[i];
+    }
+    return sum;
+  }
+
+  void Build(int o, int l, int r) {
+    pos_[o] = l;
+    if (l == r) {
+      return;
+    }
+    int mid = (l + r) / 2;
+    Build(o * 2, l, mid);
+    Build(o * 2 + 1, mid + 1, r);
+  }
+
+  void Pull(int o) {
+    // 相等时取左边，保证结果确定
+    int c = mx_[o * 2] >= mx_[o * 2 + 1] ? o * 2 : o * 2 + 1;
+    mx_[o] = mx_[c] + lazy_[o];
+    pos_[o] = pos_[c];
+  }
+
+  void RangeAdd(int o, int l, int r, int ql, int qr, int d) {
+    if (ql <= l && r <= qr) {
+      mx_[o] += d;
+      lazy_[o] += d;
+      return;
+    }
+    int mid = (l + r) / 2;
+    if (ql <= mid) {
+      RangeAdd(o * 2, l, mid, ql, qr, d);
+    }
+    if (qr > mid) {
+      RangeAdd(o * 2 + 1, mid + 1, r, ql, qr, d);
+    }
+    Pull(o);
+  }
+
+  int v_;                 // 磁盘容量
+  int width_;             // 桶宽
+  int nb_;                // 桶数
+  int k_;                 // 窗口包含的桶数
+  std::vector<int> fen_;  // 按块的树状数组
+  std::vector<int> mx_;   // 子树内窗口请求数的最大值（含本节点的懒标记）
+  std::vector<int> pos_;  // 最大值所在的窗口
+  std::vector<int> lazy_; // 整个子树的区间加
+};
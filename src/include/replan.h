@@ -0,0 +1,73 @@
+#pragma once
+
+#include "config.h"
+#include "data.h"
+#include "deadline.h"
+#include "init.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#ifndef _TIMESLICE
+#define _TIMESLICE
+extern int timeslice; // 全局变量，表示时间片
+#endif
+
+// 在线重新分配
+// 记录每个时间片分组里各标签实际的写入、删除、读取量，每个分组结束时用
+// 「已经结束的分组的实际值 + 之后分组的预测值」重新求解资源分配：
+// 从磁盘上各段当前的容量热启动，只考虑当前分组之后的占用高峰
+// 求解不看墙钟，只做 REPLAN_MAX_ITER 次迭代，同样的输入得到同样的方案
+class Replanner {
+public:
+  // 参数：
+  // - t, m, n, v, g: 输入头部的参数
+  // - delete_data, write_data, read_data: 每个标签每个分组的预测值
+  // - solution: 初始化阶段求出的分配方案
+  Replanner(int t, int m, int n, int v, int g, Data delete_data,
+            Data write_data, Data read_data,
+            std::vector<std::vector<int>> solution)
+      : t_(t), m_(m), n_(n), v_(v), g_(g),
+        forecast_{std::move(delete_data), std::move(write_data),
+                  std::move(read_data)},
+        observed_{Data(m, forecast_[0].N), Data(m, forecast_[0].N),
+                  Data(m, forecast_[0].N)},
+        solution_(std::move(solution)) {}
+
+  void Delete(int tag, int size) { observed_[0][tag][Window()] += size; }
+  void Write(int tag, int size) { observed_[1][tag][Window()] += size; }
+  void Read(int tag, int size) { observed_[2][tag][Window()] += size; }
+
+  // 前 w 个分组结束后重新求解
+  // 参数：
+  // - layout: 各段当前的容量，格式和初始化的分配方案相同
+  // 返回值：新的分配方案
+  auto Replan(int w, const std::vector<std::vector<int>> &layout)
+      -> const std::vector<std::vector<int>> & {
+    std::vector<Data> data = forecast_;
+    for (int k = 0; k < 3; k++) {
+      for (int i = 0; i < m_; i++) {
+        std::copy_n(observed_[k][i].begin(), std::min(w, data[k].N),
+                    data[k][i].begin());
+      }
+    }
+    deadline::Clear(); // 初始化阶段的时间预算早已用完
+    solution_ = InitResourceAllocator(t_, m_, n_, v_, g_, data[0], data[1],
+                                      data[2], &layout, w - 1,
+                                      config::REPLAN_MAX_ITER)
+                    .first;
+    return solution_;
+  }
+
+private:
+  // 当前时间片所在的分组，最后 105 个附加时间片算在最后一个分组里
+  auto Window() const -> int {
+    return std::min((timeslice - 1) / config::TIME_SLICE_DIVISOR,
+                    forecast_[0].N - 1);
+  }
+
+  int t_, m_, n_, v_, g_;                  // 输入头部的参数
+  std::vector<Data> forecast_;             // 预测值：删除、写入、读取
+  std::vector<Data> observed_;             // 实际值：删除、写入、读取
+  std::vector<std::vector<int>> solution_; // 最近一次求出的分配方案
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "config.h"
+#include "deadline.h"
 #include "resource_allocator.h"
 #include <algorithm>
 #include <cassert>
@@ -8,10 +9,14 @@
 #include <iostream>
 #include <limits>
 #include <random>
+#include <thread>
 #include <vector>
 
-class AnnealOptimizer {
-private:
+// 资源分配问题：m 种资源分配到 n 个容器，每个容器恰好装满 v，资源 i 的总量为 r[i]
+// 惩罚 = 同一容器内两两资源的混合惩罚 alpha + 超过阈值 l 部分的平方惩罚
+// 各种分配器共用这里的数据、惩罚函数和可行解构造
+class AllocationProblem {
+protected:
   int m_;                                // 资源种类数
   int n_;                                // 容器数量
   int v_;                                // 每个容器的容量
@@ -22,32 +27,136 @@ private:
   // 惩罚系数
   db beta_, gama_;                     // 超额部分惩罚系数
   std::vector<std::vector<db>> alpha_; // 资源混合惩罚系数
-
-  // 随机数生成器
-  std::mt19937 rng_;
+  std::vector<db> a_; // 对称化的混合惩罚系数，a_[i * m_ + k]，对角线为 0
 
   // **计算当前分配方案的惩罚值**
-  auto ComputePenalty(const std::vector<std::vector<int>> &x) const -> db {
+  // x 按容器连续存放，x[j * m_ + i] 表示容器 j 中资源 i 的数量
+  auto ComputePenalty(const std::vector<int> &x) const -> db {
     db penalty = 0.0;
 
     for (int j = 0; j < n_; ++j) {
+      const int *col = &x[j * m_];
       // 计算混合惩罚项
       for (int i = 0; i < m_; ++i) {
         for (int k = i + 1; k < m_; ++k) {
-          penalty += alpha_[i][k] * x[i][j] * x[k][j];
+          penalty += alpha_[i][k] * col[i] * col[k];
         }
       }
       // 计算超额惩罚项
       for (int i = 0; i < m_; ++i) {
-        int s_ij = std::max(0, x[i][j] - l_);
-        penalty += beta_ * s_ij * s_ij;
+        penalty += OverflowPenalty(col[i]);
       }
     }
     return penalty;
   }
 
+  // 单个格子的超额惩罚
+  auto OverflowPenalty(int v) const -> db {
+    int s = std::max(0, v - l_);
+    return beta_ * s * s;
+  }
+
+  // **计算容器 j 中资源 i1 增加 d、资源 i2 减少 d 后惩罚值的变化量**
+  // 只涉及这一列，复杂度 O(m)
+  auto ColumnDelta(const std::vector<int> &x, int j, int i1, int i2,
+                   int d) const -> db {
+    const int *col = &x[j * m_];
+    const db *a1 = &a_[i1 * m_];
+    const db *a2 = &a_[i2 * m_];
+    db s1 = 0.0;
+    db s2 = 0.0;
+    for (int k = 0; k < m_; ++k) {
+      s1 += a1[k] * col[k];
+      s2 += a2[k] * col[k];
+    }
+    // 混合项：d * S(i1) - d * S(i2) - a(i1, i2) * d * d
+    db delta = d * (s1 - s2) - a1[i2] * d * d;
+    // 超额项
+    delta += OverflowPenalty(col[i1] + d) - OverflowPenalty(col[i1]);
+    delta += OverflowPenalty(col[i2] - d) - OverflowPenalty(col[i2]);
+    return delta;
+  }
+
+  // 把 m_ x n_ 的分配方案转成按容器连续存放的形式
+  auto Flatten(const std::vector<std::vector<int>> &x) const
+      -> std::vector<int> {
+    std::vector<int> flat(n_ * m_);
+    for (int i = 0; i < m_; ++i) {
+      for (int j = 0; j < n_; ++j) {
+        flat[j * m_ + i] = x[i][j];
+      }
+    }
+    return flat;
+  }
+
+  auto Unflatten(const std::vector<int> &flat) const
+      -> std::vector<std::vector<int>> {
+    std::vector<std::vector<int>> x(m_, std::vector<int>(n_));
+    for (int i = 0; i < m_; ++i) {
+      for (int j = 0; j < n_; ++j) {
+        x[i][j] = flat[j * m_ + i];
+      }
+    }
+    return x;
+  }
+
+  // **修复每种资源的总量**：每个容器的和已经是 v 时，在列内把多的资源换成
+  // 少的资源，从第 off 个容器开始依次处理
+  void RepairRows(std::vector<int> &x, int off) const {
+    std::vector<int> diff(m_);
+    for (int i = 0; i < m_; ++i) {
+      diff[i] = -r_[i];
+      for (int j = 0; j < n_; ++j) {
+        diff[i] += x[j * m_ + i];
+      }
+    }
+    for (int i = 0; i < m_; ++i) {
+      for (int jj = 0; jj < n_ && diff[i] > 0; ++jj) {
+        int *col = &x[((jj + off) % n_) * m_];
+        for (int k = 0; k < m_ && diff[i] > 0 && col[i] > 0; ++k) {
+          if (diff[k] >= 0) {
+            continue;
+          }
+          int t = std::min({diff[i], -diff[k], col[i]});
+          col[i] -= t;
+          col[k] += t;
+          diff[i] -= t;
+          diff[k] += t;
+        }
+      }
+    }
+  }
+
+  // **把相近问题的解修复成当前问题的可行解**
+  // 先让每个容器的和恰好为 v，再修复每种资源的总量
+  auto RepairSolution(const std::vector<std::vector<int>> &x) const
+      -> std::vector<int> {
+    std::vector<int> flat = Flatten(x);
+    for (int j = 0; j < n_; ++j) {
+      int *col = &flat[j * m_];
+      int sum = 0;
+      for (int i = 0; i < m_; ++i) {
+        col[i] = std::max(0, col[i]);
+        sum += col[i];
+      }
+      // 多了从最大的格子减，少了加到资源总量最大的格子
+      while (sum > v_) {
+        int i = std::max_element(col, col + m_) - col;
+        int d = std::min(sum - v_, col[i]);
+        col[i] -= d;
+        sum -= d;
+      }
+      if (sum < v_) {
+        col[std::max_element(r_.begin(), r_.end()) - r_.begin()] += v_ - sum;
+      }
+    }
+    RepairRows(flat, 0);
+    return flat;
+  }
+
   // **初始化可行解**
-  auto InitializeSolution() -> std::vector<std::vector<int>> {
+  auto InitializeSolution(std::mt19937 &rng) const
+      -> std::vector<std::vector<int>> {
     std::vector<std::vector<int>> x(m_, std::vector<int>(n_, 0));
     std::vector<int> remaining_r = r_; // 记录每种资源剩余可分配数量
     std::vector<int> remaining_v(n_, v_); // 记录每个容器剩余容量
@@ -58,7 +167,7 @@ private:
     // **第一步：均匀分配资源，保证 r[i] 约束**
     for (int i = 0; i < m_; ++i) {
       while (remaining_r[i] > 0) {
-        int j = dist_n(rng_);     // 随机选择容器
+        int j = dist_n(rng);     // 随机选择容器
         if (remaining_v[j] > 0) { // 容器仍有可用容量
           int allocate_amount = std::min({remaining_r[i], remaining_v[j], 1});
           x[i][j] += allocate_amount;
@@ -76,7 +185,7 @@ private:
       int diff = sum - v_;
 
       while (diff != 0) {
-        int i = dist_m(rng_);
+        int i = dist_m(rng);
         if (diff > 0 && x[i][j] > 0) { // 超配，减少
           int adjust = std::min(diff, x[i][j]);
           x[i][j] -= adjust;
@@ -93,70 +202,22 @@ private:
     return x;
   }
 
-public:
-  // **构造函数**
-  AnnealOptimizer(int m, int n, int v, int l, const std::vector<int> &r,
-                  const std::vector<std::vector<db>> &alpha,
-                  db beta = config::BETA_VALUE, db gama = config::GAMA_VALUE)
-      : m_(m), n_(n), v_(v), l_(l), r_(r), alpha_(alpha), beta_(beta),
-        gama_(gama), best_penalty_(std::numeric_limits<db>::max()),
-        rng_(config::RANDOM_SEED) {}
-
-  // **执行模拟退火优化**
-  auto Solve(bool iscerr = false, db T = config::T,
-             db coolingRate = config::COOLING_RATE,
-             int maxIter = config::MAX_ITER) -> void {
-    std::vector<std::vector<int>> x = InitializeSolution();
-    db e_cur = ComputePenalty(x);
-    best_x_ = x;
-    best_penalty_ = e_cur;
-
-    std::uniform_int_distribution<int> dist_n(0, n_ - 1);
-    std::uniform_int_distribution<int> dist_m(0, m_ - 1);
-
-    for (int iter = 0; iter < maxIter; ++iter) {
-      std::vector<std::vector<int>> x_new = x;
-      int i1 = dist_m(rng_);
-      int i2 = dist_m(rng_);
-      int j1 = dist_n(rng_);
-      int j2 = dist_n(rng_);
-      std::uniform_int_distribution<int> dist_r(0,
-                                                std::min(x[i2][j1], x[i1][j2]));
-      int delta = dist_r(rng_);
-      x_new[i1][j1] += delta;
-      x_new[i2][j1] -= delta;
-      x_new[i2][j2] += delta;
-      x_new[i1][j2] -= delta;
-
-      // **计算新解的惩罚值**
-      db e_new = ComputePenalty(x_new);
-
-      // **接受新解的策略**
-      if (e_new < e_cur ||
-          std::exp(-(e_new - e_cur) / T) >
-              std::uniform_real_distribution<db>(0.0, 1.0)(rng_)) {
-        x = x_new;
-        e_cur = e_new;
-        if (e_new < best_penalty_) {
-          best_penalty_ = e_new;
-          best_x_ = x;
-        }
-      }
-      // **温度衰减**
-      T *= coolingRate;
-
-      // **终止条件**
-      if (T < config::EPS_T) {
-#ifdef ISCERR
-        { std::cerr << "epoch=" << iter << '\n'; }
-#endif
-        break;
+  AllocationProblem(int m, int n, int v, int l, const std::vector<int> &r,
+                    const std::vector<std::vector<db>> &alpha, db beta,
+                    db gama)
+      : m_(m), n_(n), v_(v), l_(l), r_(r),
+        best_penalty_(std::numeric_limits<db>::max()), beta_(beta),
+        gama_(gama), alpha_(alpha), a_(m * m, 0.0) {
+    for (int i = 0; i < m_; ++i) {
+      for (int k = i + 1; k < m_; ++k) {
+        a_[i * m_ + k] = a_[k * m_ + i] = alpha_[i][k];
       }
     }
-    //**调整最后的资源**
-    // AdjustSolution(best_x_);
   }
 
+public:
+  auto GetBestPenalty() const -> db { return best_penalty_; }
+
   // **获取最优解**
   auto
   GetBestSolution(bool iscerr = false) const -> std::vector<std::vector<int>> {
@@ -189,4 +250,244 @@ public:
     return best_x_;
   }
 };
-using ResourceAllocator = AnnealOptimizer;
+
+class AnnealOptimizer : public AllocationProblem {
+private:
+  // 随机数生成器
+  std::mt19937 rng_;
+
+  // 当前解与最优解，按容器连续存放，见 ComputePenalty
+  std::vector<int> x_, best_flat_;
+  std::vector<int> warm_; // 热启动的初始解，为空时从随机可行解开始
+  db e_cur_{}; // 当前解的惩罚值
+
+public:
+  // **构造函数**
+  AnnealOptimizer(int m, int n, int v, int l, const std::vector<int> &r,
+                  const std::vector<std::vector<db>> &alpha,
+                  db beta = config::BETA_VALUE, db gama = config::GAMA_VALUE,
+                  unsigned seed = config::RANDOM_SEED)
+      : AllocationProblem(m, n, v, l, r, alpha, beta, gama), rng_(seed) {}
+
+  // **指定热启动的初始解**，x 可以来自相近的问题，这里先修复成可行解
+  void WarmStart(const std::vector<std::vector<int>> &x) {
+    warm_ = RepairSolution(x);
+  }
+
+  // **从热启动解或随机可行解开始重置当前状态**
+  void Reset() {
+    x_ = warm_.empty() ? Flatten(InitializeSolution(rng_)) : warm_;
+    e_cur_ = ComputePenalty(x_);
+    best_flat_ = x_;
+    best_penalty_ = e_cur_;
+  }
+
+  // **在温度 T 下尝试一次随机交换**
+  void Step(db T) {
+    std::uniform_int_distribution<int> dist_n(0, n_ - 1);
+    std::uniform_int_distribution<int> dist_m(0, m_ - 1);
+    int i1 = dist_m(rng_);
+    int i2 = dist_m(rng_);
+    int j1 = dist_n(rng_);
+    int j2 = dist_n(rng_);
+    std::uniform_int_distribution<int> dist_r(
+        0, std::min(x_[j1 * m_ + i2], x_[j2 * m_ + i1]));
+    int delta = dist_r(rng_);
+
+    // **增量计算新解的惩罚值**
+    // 容器 j1 中 i1 加 delta、i2 减 delta，容器 j2 相反，i1 == i2 或
+    // j1 == j2 时方案不变
+    db e_new = e_cur_;
+    if (i1 != i2 && j1 != j2 && delta != 0) {
+      e_new += ColumnDelta(x_, j1, i1, i2, delta) +
+               ColumnDelta(x_, j2, i2, i1, delta);
+    }
+
+    // **接受新解的策略**，只有接受时才原地修改
+    if (e_new < e_cur_ ||
+        std::exp(-(e_new - e_cur_) / T) >
+            std::uniform_real_distribution<db>(0.0, 1.0)(rng_)) {
+      x_[j1 * m_ + i1] += delta;
+      x_[j1 * m_ + i2] -= delta;
+      x_[j2 * m_ + i2] += delta;
+      x_[j2 * m_ + i1] -= delta;
+      e_cur_ = e_new;
+      if (e_new < best_penalty_) {
+        best_penalty_ = e_new;
+        best_flat_ = x_;
+      }
+    }
+  }
+
+  // **从温度 T 开始降温，直到 EPS_T 或达到 maxIter**
+  // 返回值：实际迭代次数
+  auto Anneal(db T, db coolingRate, int maxIter) -> int {
+    for (int iter = 0; iter < maxIter; ++iter) {
+      if ((iter & 1023) == 0 && deadline::Expired()) {
+        return iter; // 时间预算用完，保留当前最优解
+      }
+      Step(T);
+      // **温度衰减**
+      T *= coolingRate;
+
+      // **终止条件**
+      if (T < config::EPS_T) {
+        return iter;
+      }
+    }
+    return maxIter;
+  }
+
+  // **把最优解整理成 m_ x n_ 的矩阵**
+  void Finish() {
+    //**调整最后的资源**
+    // AdjustSolution(best_x_);
+    best_x_ = Unflatten(best_flat_);
+    best_penalty_ = ComputePenalty(best_flat_); // 消除增量累加的浮点误差
+  }
+
+  // **执行模拟退火优化**
+  auto Solve(bool iscerr = false, db T = config::T,
+             db coolingRate = config::COOLING_RATE,
+             int maxIter = config::MAX_ITER) -> void {
+    Reset();
+    [[maybe_unused]] int epoch = Anneal(T, coolingRate, maxIter);
+#ifdef ISCERR
+    { std::cerr << "epoch=" << epoch << '\n'; }
+#endif
+    Finish();
+  }
+
+  auto GetEnergy() const -> db { return e_cur_; }
+
+  // **交换两条链的当前状态（并行回火用）**
+  void SwapState(AnnealOptimizer &other) {
+    std::swap(x_, other.x_);
+    std::swap(e_cur_, other.e_cur_);
+  }
+};
+
+// 在 cnt 个线程上分别执行 f(k)，k = 0 在当前线程执行
+template <typename F> void ParallelFor(int cnt, const F &f) {
+  std::vector<std::thread> threads;
+  threads.reserve(std::max(0, cnt - 1));
+  for (int k = 1; k < cnt; k++) {
+    threads.emplace_back(f, k);
+  }
+  f(0);
+  for (auto &t : threads) {
+    t.join();
+  }
+}
+
+// 并行模拟退火，每条链一个线程，返回所有链中最优的解
+// - restart：每条链用不同的种子各自完成一次完整退火
+// - tempering：链 k 的温度是链 0 的 PT_LADDER^k 倍，一起降温，每
+//   PT_EXCHANGE_INTERVAL 次迭代相邻两条链按 Metropolis 准则交换状态
+// 链 k 的种子为 seed + k，交换由主线程的随机数决定，结果只取决于链数和种子
+class ParallelAnnealOptimizer {
+public:
+  ParallelAnnealOptimizer(int m, int n, int v, int l, const std::vector<int> &r,
+                          const std::vector<std::vector<db>> &alpha,
+                          db beta = config::BETA_VALUE,
+                          db gama = config::GAMA_VALUE,
+                          int chains = config::ANNEAL_THREADS,
+                          config::ANNEALMODES mode = config::ANNEAL_MODE,
+                          unsigned seed = config::RANDOM_SEED)
+      : mode_(mode), rng_(seed) {
+    chains = std::max(1, chains);
+    chains_.reserve(chains);
+    for (int k = 0; k < chains; k++) {
+      chains_.emplace_back(m, n, v, l, r, alpha, beta, gama, seed + k);
+    }
+  }
+
+  // **执行并行模拟退火**
+  auto Solve(bool iscerr = false, db T = config::T,
+             db coolingRate = config::COOLING_RATE,
+             int maxIter = config::MAX_ITER) -> void {
+    if (mode_ == config::ANNEALMODES::tempering) {
+      SolveTempering(T, coolingRate, maxIter);
+    } else {
+      SolveRestart(T, coolingRate, maxIter);
+    }
+    best_ = 0;
+    for (int k = 1; k < static_cast<int>(chains_.size()); k++) {
+      if (chains_[k].GetBestPenalty() < chains_[best_].GetBestPenalty()) {
+        best_ = k;
+      }
+    }
+#ifdef ISCERR
+    for (const auto &c : chains_) {
+      std::cerr << c.GetBestPenalty() << ' ';
+    }
+    std::cerr << "best chain=" << best_ << '\n';
+#endif
+  }
+
+  auto GetBestPenalty() const -> db { return chains_[best_].GetBestPenalty(); }
+
+  // **所有链从同一个热启动解出发**
+  void WarmStart(const std::vector<std::vector<int>> &x) {
+    for (auto &c : chains_) {
+      c.WarmStart(x);
+    }
+  }
+
+  // **获取最优解**
+  auto
+  GetBestSolution(bool iscerr = false) const -> std::vector<std::vector<int>> {
+    return chains_[best_].GetBestSolution(iscerr);
+  }
+
+private:
+  // 每条链一个线程执行 f(k)
+  template <typename F> void RunAll(const F &f) {
+    ParallelFor(static_cast<int>(chains_.size()), f);
+  }
+
+  void SolveRestart(db T, db coolingRate, int maxIter) {
+    RunAll([&](int k) {
+      chains_[k].Reset();
+      chains_[k].Anneal(T, coolingRate, maxIter);
+      chains_[k].Finish();
+    });
+  }
+
+  void SolveTempering(db T, db coolingRate, int maxIter) {
+    int c = chains_.size();
+    std::vector<db> temp(c, T);
+    for (int k = 1; k < c; k++) {
+      temp[k] = temp[k - 1] * config::PT_LADDER;
+    }
+    RunAll([&](int k) { chains_[k].Reset(); });
+    for (int iter = 0, round = 0; iter < maxIter && temp[0] >= config::EPS_T &&
+                                  !deadline::Expired();
+         iter += config::PT_EXCHANGE_INTERVAL, round++) {
+      int len = std::min(config::PT_EXCHANGE_INTERVAL, maxIter - iter);
+      RunAll([&](int k) {
+        for (int i = 0; i < len && temp[k] >= config::EPS_T; i++) {
+          chains_[k].Step(temp[k]);
+          temp[k] *= coolingRate;
+        }
+      });
+      // 奇偶轮交替交换 (0,1)(2,3)... 和 (1,2)(3,4)...
+      for (int k = round & 1; k + 1 < c; k += 2) {
+        db d = (1.0 / temp[k] - 1.0 / temp[k + 1]) *
+               (chains_[k].GetEnergy() - chains_[k + 1].GetEnergy());
+        if (d >= 0 ||
+            std::exp(d) > std::uniform_real_distribution<db>(0.0, 1.0)(rng_)) {
+          chains_[k].SwapState(chains_[k + 1]);
+        }
+      }
+    }
+    RunAll([&](int k) { chains_[k].Finish(); });
+  }
+
+  config::ANNEALMODES mode_;             // 并行方式
+  std::mt19937 rng_;                     // 交换决策用的随机数生成器
+  std::vector<AnnealOptimizer> chains_;  // 各条退火链
+  int best_{0};                          // 最优解所在的链
+};
+
+using ResourceAllocator = ParallelAnnealOptimizer;
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "config.h"
+#include "scheduler.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// RTQ 的微基准：和原来基于 std::set + unordered_map 的读取队列比较
+// 定义 RTQ_BENCH 后程序启动时运行，结果输出到 stderr
+namespace bench {
+
+// 原来的读取队列（只保留基准用到的操作）
+class SetRTQ {
+public:
+  void Push(int x) {
+    st_.insert(x);
+    ++cnt_[x];
+  }
+
+  void Remove(int x) {
+    if (cnt_.count(x) == 0) {
+      return;
+    }
+    st_.erase(x);
+    cnt_.erase(x);
+  }
+
+  auto Front(int pos) -> int {
+    if (st_.empty()) {
+      return -1;
+    }
+    auto it = st_.lower_bound(pos);
+    if (it == st_.end()) {
+      it = st_.begin();
+    }
+    return *it;
+  }
+
+  auto FrontK(int pos, int k) -> std::vector<int> {
+    if (st_.empty()) {
+      return {};
+    }
+    auto it = st_.lower_bound(pos);
+    std::vector<int> res;
+    res.reserve(k);
+    for (; it != st_.end() && k > 0; ++it) {
+      res.push_back(*it);
+      --k;
+    }
+    for (it = st_.begin(); it != st_.end() && *it < pos && k > 0; ++it) {
+      res.push_back(*it);
+      --k;
+    }
+    return res;
+  }
+
+private:
+  std::set<int> st_;
+  std::unordered_map<int, int> cnt_;
+};
+
+// 模拟读调度的访问模式：随机到达的请求、磁头顺序前进、读到就删除
+// 返回值：{耗时（纳秒），校验和}
+template <typename Q> auto Run(Q &q, int v, int ops) -> std::pair<long long, long long> {
+  std::mt19937 rng(config::RANDOM_SEED);
+  std::uniform_int_distribution<int> block(0, v - 1);
+  long long checksum = 0;
+  int pos = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ops; i++) {
+    q.Push(block(rng));
+    q.Push(block(rng));
+    int x = q.Front(pos);
+    if (x != -1) {
+      checksum += x;
+      q.Remove(x);
+      pos = x + 1 == v ? 0 : x + 1;
+    }
+    if ((i & 15) == 0) {
+      for (int y : q.FrontK(pos, config::DISK_READ_FETCH_LEN)) {
+        checksum += y;
+      }
+    }
+  }
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  return {ns, checksum};
+}
+
+void RTQBench() {
+  constexpr int OPS = 1 << 20;
+  for (int v : {16384, 32768, 65536}) {
+    SetRTQ old_q;
+    RTQ new_q(v);
+    auto [old_ns, old_sum] = Run(old_q, v, OPS);
+    auto [new_ns, new_sum] = Run(new_q, v, OPS);
+    std::cerr << "rtq V=" << v << " set=" << static_cast<db>(old_ns) / OPS
+              << "ns/op bitset=" << static_cast<db>(new_ns) / OPS
+              << "ns/op speedup=" << static_cast<db>(old_ns) / new_ns
+              << (old_sum == new_sum ? "" : " MISMATCH") << '\n';
+  }
+}
+
+} // namespace bench
@@ -1,16 +1,16 @@
 #pragma once
 
+#include "bitset.h"
 #include "config.h"
 #include "disk.h"
 #include "object.h"
 #include "printer.h"
+#include "region_index.h"
 #include "task.h"
 #include <algorithm>
 #include <cassert>
-#include <list>
 #include <memory>
-#include <set>
-#include <unordered_map>
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -19,63 +19,53 @@
 extern int timeslice; // 全局变量，表示时间片
 #endif
 
-class TaskManager;
-
-namespace printer {
-void AddDeleteObject(TaskManager &t);
-};
-
 /**
 1. 尽量一次读完某个 TAG
 2. 读某个 TAG 尽量让指针同方向移动
 3. 设置时间片轮转机制防止饥饿
 */
+// 每个磁盘的读取队列：cnt_ 记录每个块被请求的次数，两级位图 bits_
+// 记录哪些块有请求，找下一个有请求的块只需按字扫描并取最低位
+// region_ 按区域统计请求数，用来找最热的区域
 class RTQ {
 private:
   void UpdateSum(int x, int v = 1) {
-    auto it = std::upper_bound(sum_.begin(), sum_.end(),
-                               std::make_pair(x, INT32_MAX));
-    assert(it != sum_.begin());
-    it = prev(it);
-    it->second += v;
+    region_.Add(x, v);
     read_stress_ += v;
   }
 
 public:
   // 构造函数
-  explicit RTQ(int V) {
-    for (int i = 0; i < V; i += V) {
-      sum_.emplace_back(i, 0);
-    }
-    sum_.emplace_back(V, 0);
-  }
+  explicit RTQ(int V)
+      : cnt_(V, 0), bits_(V),
+        region_(V, config::RTQ_BUCKET_WIDTH, config::RTQ_DISK_PART_SIZE) {}
 
   // 将块 ID 添加到队列中
   void Push(int x) {
-    st_.insert(x);
-    ++cnt_[x];
+    if (cnt_[x]++ == 0) {
+      bits_.Set(x);
+    }
     UpdateSum(x);
   }
 
   // 从队列中移除指定块 ID
   void Remove(int x) {
-    if (cnt_.count(x) == 0) {
+    if (cnt_[x] == 0) {
       return;
     }
     UpdateSum(x, -cnt_[x]);
-    st_.erase(x);
-    cnt_.erase(x);
+    cnt_[x] = 0;
+    bits_.Reset(x);
   }
 
   // 删除一次请求
   void RemoveOnce(int x) {
-    if (cnt_.count(x) == 0) {
+    if (cnt_[x] == 0) {
       return;
     }
     UpdateSum(x, -1);
     if (--cnt_[x] == 0) {
-      st_.erase(x);
-      cnt_.erase(x);
+      bits_.Reset(x);
     }
   }
 
@@ -83,168 +73,146 @@ public:
   // 参数：
   // - pos: 当前磁盘指针的位置
   // 返回值：最接近的块 ID，如果队列为空则返回 -1
-  auto Front(int pos) -> int {
-    if (st_.empty()) {
+  auto Front(int pos) const -> int {
+    if (bits_.Count() == 0) {
       return -1; // 队列为空
     }
-    auto it = st_.lower_bound(pos); // 找到第一个大于等于 pos 的块
-    if (it == st_.end()) {
-      it = st_.begin(); // 如果没有找到，则从头开始
-    }
-    return *it;
+    int x = bits_.Next(pos); // 找到第一个大于等于 pos 的块
+    return x != -1 ? x : bits_.Next(0); // 如果没有找到，则从头开始
   }
 
-  auto FrontK(int pos, int k) -> std::vector<int> {
-    if (st_.empty()) {
+  auto FrontK(int pos, int k) const -> std::vector<int> {
+    if (bits_.Count() == 0) {
       return {};
     }
-    auto it = st_.lower_bound(pos); // 找到第一个大于等于 pos 的块
     std::vector<int> res;
     res.reserve(k);
-    for (; it != st_.end() && k > 0; ++it) {
-      res.push_back(*it);
+    for (int x = bits_.Next(pos); x != -1 && k > 0; x = bits_.Next(x + 1)) {
+      res.push_back(x);
       --k;
     }
     // 再从头开始找，因为磁盘是布局一个环
-    for (it = st_.begin(); it != st_.end() && *it < pos && k > 0; ++it) {
-      res.push_back(*it);
+    for (int x = bits_.Next(0); x != -1 && x < pos && k > 0;
+         x = bits_.Next(x + 1)) {
+      res.push_back(x);
       --k;
     }
     return res;
   }
 
   // 获取队列的大小
-  auto GetSize() -> int { return st_.size(); }
-
-  // 得到最热门的块
-  auto GetHotBlock() -> std::pair<int, int> {
-    int mx = 0;
-    int pos = 0;
-    for (const auto &[x, y] : sum_) {
-      if (mx < y) {
-        pos = x;
-        mx = y;
-      }
-    }
+  auto GetSize() const -> int { return bits_.Count(); }
+
+  // 得到最热门的块：请求最多的窗口里的第一个待读块
+  // 返回值：{块 ID, 窗口内的请求数}，队列为空时块 ID 为 -1
+  auto GetHotBlock() const -> std::pair<int, int> {
+    auto [pos, mx] = region_.Densest();
     return {Front(pos), mx};
   }
 
-  // 查询块查询次数
-  auto QueryBlockCnt(int pos) -> int {
-    auto it = std::upper_bound(sum_.begin(), sum_.end(),
-                               std::make_pair(pos, INT32_MAX));
-    assert(it != sum_.begin());
-    it = prev(it);
-    return it->second;
-  }
+  // 查询从 pos 开始一个窗口内的请求数
+  auto QueryBlockCnt(int pos) const -> int { return region_.WindowWeight(pos); }
+
+  // 块 x 上的请求数
+  auto Count(int x) const -> int { return cnt_[x]; }
 
   auto QueryReadStress() -> int {
     return read_stress_; // 返回读取压力
   }
 
   auto Trans(int x, int y) -> void {
-    if (st_.find(x) == st_.end()) {
+    if (cnt_[x] == 0) {
       return;
     }
-    assert(st_.find(y) == st_.end());
+    assert(cnt_[y] == 0);
     int tmp = cnt_[x];
     Remove(x);
-    st_.insert(y);
     cnt_[y] = tmp;
+    bits_.Set(y);
     UpdateSum(y, tmp);
   }
 
 private:
-  std::set<int> st_; // 使用有序集合维护块 ID，支持快速查找和删除
-  std::vector<std::pair<int, int>> sum_; // 前缀和
-  std::unordered_map<int, int> cnt_;     // 出现次数
+  std::vector<int> cnt_;           // 每个块的请求次数
+  LevelBitset bits_;               // 有请求的块
+  RegionIndex region_;             // 热点区域索引
   int read_stress_{0};                   // 读取压力
 };
 
 // 每个对象一个 TaskManager，用于管理对象的任务
+// 每个未完成的任务记录还没读到的块数，每个块记录在等它的任务，
+// 读完一个块只需处理等这个块的任务
+// 任务完成或对象被删除时回收任务的槽位；超时的任务标记为繁忙，
+// 仍然留在这里直到读完
 class TaskManager {
 public:
   // 构造函数
   // 参数：
   // - n: 对象的块数
-  explicit TaskManager(int n) : mask_((1 << n) - 1) { l_.resize(mask_ + 1); }
+  // - pool: 任务池
+  TaskManager(int n, TaskPool *pool) : pool_(pool), wait_(n) {}
 
-  // 添加新任务
+  // 添加新任务，等待对象的所有块
   // 参数：
-  // - ptr: 指向任务的智能指针
-  void NewTask(std::shared_ptr<Task> ptr) {
-    l_[0].emplace_back(std::move(ptr)); // 将任务添加到初始状态
-  }
-
-  // 完成所有任务
-  void Finish() {
-    if (!l_[mask_].empty()) { // 遍历所有已完成的任务
-      for (const auto &p : l_[mask_]) {
-        // 引用计数大于 1 说明任务没有先繁忙
-        if (p.use_count() > 1) {
-          assert(p->timestamp_ > timeslice - config::REQ_BUSY_TIME);
-          printer::AddReadRequest(p->tid_); // 将任务 ID 添加到读取请求
-        }
-      }
-      l_[mask_].clear(); // 清空已完成任务列表
+  // - h: 任务句柄
+  void NewTask(TaskHandle h) {
+    auto &t = pool_->Get(h);
+    t.remain_ = wait_.size();
+    t.slot_ = live_.size();
+    for (auto &w : wait_) {
+      w.push_back(h);
     }
+    live_.push_back(h);
   }
 
   // 更新任务状态
   // 参数：
   // - x: 已完成的块编号
   void Update(int x) {
-    assert((1 << x) <= mask_); // 确保块编号合法
-    for (int i = 0; i <= mask_; i++) {
-      if (((i >> x) & 1) == 0) { // 如果块 x 未完成
-        assert((i | (1 << x)) != i);
-        l_[i | (1 << x)].splice(l_[i | (1 << x)].end(), l_[i]); // 更新状态
-        assert(l_[i].empty());
+    assert(x >= 0 && x < static_cast<int>(wait_.size())); // 确保块编号合法
+    for (auto h : wait_[x]) {
+      if (--pool_->Get(h).remain_ == 0) {
+        Finish(h); // 所有块都读到了
       }
     }
-    Finish(); // 检查是否有任务完成
+    wait_[x].clear();
   }
 
-  // 清空所有任务
+  // 对象被删除，上报所有还在等待的任务并清空
   void Clear() {
     valid_ = false;
-    for (int i = 0; i <= mask_; i++) {
-      l_[i].clear();
-    }
-  }
-
-  void Trans(int x, int y) {
-    for (int i = 0; i <= mask_; i++) {
-      for (auto &task_list : l_) {
-        for (auto &task : task_list) {
-          task->TransWork(x, y);
-        }
+    for (auto h : live_) {
+      auto &t = pool_->Get(h);
+      if (t.state_ == TaskState::pending) {
+        printer::AddDeletedRequest(t.tid_); // 添加删除请求
       }
+      pool_->Release(h);
+    }
+    live_.clear();
+    for (auto &w : wait_) {
+      w.clear();
     }
   }
 
-  // 友元函数，用于打印删除的对象
-  friend void printer::AddDeleteObject(TaskManager &t);
-
 private:
-  bool valid_{true}; // 表示对象是否已经被删除
-  int mask_;         // 状态掩码，用于表示块的读取状态
-  // 状态压缩，最多支持 32 种块的读/未读状态
-  std::vector<std::list<std::shared_ptr<Task>>> l_;
-};
-
-namespace printer {
-// 打印删除的对象
-void AddDeleteObject(TaskManager &t) {
-  for (const auto &l : t.l_) {
-    for (const auto &p : l) {
-      if (p.use_count() > 1) {
-        AddDeletedRequest(p->tid_); // 添加删除请求
-      }
+  // 完成任务并从未完成列表中移除
+  void Finish(TaskHandle h) {
+    auto &t = pool_->Get(h);
+    pool_->Get(live_.back()).slot_ = t.slot_;
+    live_[t.slot_] = live_.back();
+    live_.pop_back();
+    if (t.state_ == TaskState::pending) {
+      assert(t.timestamp_ > timeslice - config::REQ_BUSY_TIME);
+      printer::AddReadRequest(t.tid_); // 将任务 ID 添加到读取请求
     }
+    pool_->Release(h);
   }
-}
-} // namespace printer
+
+  bool valid_{true};                        // 表示对象是否已经被删除
+  TaskPool *pool_;                          // 任务池
+  std::vector<TaskHandle> live_;            // 未完成的任务
+  std::vector<std::vector<TaskHandle>> wait_; // wait_[x]：在等块 x 的任务
+};
 
 // 调度器类，用于管理磁盘的读取任务
 class Scheduler {
@@ -266,17 +234,19 @@ public:
   // - size: 对象的块数
   void NewTaskMgr(int oid, int size) {
     assert(oid == task_mgr_.size()); // 确保对象 ID 与任务管理器的大小一致
-    task_mgr_.emplace_back(size); // 创建新的任务管理器
+    task_mgr_.emplace_back(size, &tasks_); // 创建新的任务管理器
   }
 
   // 添加新任务
   // 参数：
+  // - tid: 读取请求 ID
   // - oid: 对象 ID
-  // - ptr: 指向任务的智能指针
-  void NewTask(int oid, const std::shared_ptr<Task> &ptr) {
+  // - disk: 读取的磁盘 ID
+  // - replica: 读取的副本编号
+  void NewTask(int tid, int oid, int disk, int replica) {
     assert(oid < task_mgr_.size()); // 确保对象 ID 合法
-    task_mgr_[oid].NewTask(ptr);    // 添加任务到对应的任务管理器
-    req_list_.push_back(ptr);
+    auto h = tasks_.New(tid, oid, timeslice, disk, replica);
+    task_mgr_[oid].NewTask(h); // 添加任务到对应的任务管理器
   }
 
   // 将块 ID 添加到指定磁盘的读取队列
@@ -308,6 +278,12 @@ public:
     return q_[disk_id].QueryBlockCnt(pos);
   }
 
+  // 实际磁盘 disk_id 的块 x 是否还有待读的请求（两个磁头任意一个）
+  auto Pending(int disk_id, int x) -> bool {
+    return q_[disk_id].Count(x) > 0 ||
+           q_[disk_id + config::REAL_DISK_CNT].Count(x) > 0;
+  }
+
   // 获取指定磁盘的读取队列大小
   // 参数：
   // - disk_id: 磁盘 ID
@@ -329,8 +305,7 @@ public:
             y); // 从镜像磁盘的读取队列中移除块
       }
     }
-    printer::AddDeleteObject(task_mgr_[oid]); // 打印删除的任务
-    task_mgr_[oid].Clear();                   // 清空任务管理器
+    task_mgr_[oid].Clear(); // 打印删除的任务并清空任务管理器
   }
 
   // 更新任务状态
@@ -361,25 +336,22 @@ public:
         break;
       }
     }
-    // 更新超时删除队列
-    task_mgr_[oid].Trans(x, y);
-
     q_[disk_id].Trans(x, y); // 交换读取队列中的块
     q_[disk_id + config::REAL_DISK_CNT].Trans(x, y); // 镜像磁盘也交换
   }
 
   void PopOldReqs() {
-    int lim = timeslice - config::REQ_BUSY_TIME;
-    while (!req_list_.empty() && req_list_.front()->timestamp_ <= lim) {
-      const auto &req = req_list_.front();
-      // 如果对象之前没有被删除，到对应磁盘删除读请求
-      if (obj_pool_->IsValid(req->oid_) && req.use_count() > 1) {
-        for (const auto &[disk_id, block_id] : req->work_) {
-          q_[disk_id].RemoveOnce(block_id);
+    // 时间轮上只剩还在等待的任务，到对应磁盘删除读请求，
+    // 任务留在 TaskManager 里直到读完
+    while (expired_ < timeslice - config::REQ_BUSY_TIME) {
+      tasks_.Expire(++expired_, [&](Task &req) {
+        auto object = obj_pool_->GetObjAt(req.oid_);
+        for (int block_id : object->tdisk_[req.replica_]) {
+          q_[req.disk_].RemoveOnce(block_id);
         }
-        printer::ReadAddBusy(req->tid_);
-      }
-      req_list_.pop_front();
+        printer::ReadAddBusy(req.tid_);
+        req.state_ = TaskState::busy;
+      });
     }
   }
 
@@ -393,6 +365,7 @@ private:
   */
   ObjectPool *obj_pool_;              // 对象池，用于管理对象
   std::vector<RTQ> q_;                // 每个磁盘的读取队列
+  TaskPool tasks_;                    // 所有读任务
   std::vector<TaskManager> task_mgr_; // 每个对象的任务管理器
-  std::list<std::shared_ptr<Task>> req_list_; // 支持删除 105 个时间片前的任务
+  int expired_{0};                    // 已经处理过超时的到达时间片
 };
\ No newline at end of file
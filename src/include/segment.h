@@ -17,6 +17,14 @@ public:
   int tag_;       // 段的标签，用于分类
   int capacity_;  // 段的总容量（块数）
   int size_{0};   // 段当前已使用的大小（块数）
+  int used_{0};   // 段内实际被占用的块数（不区分标签）
+  int hot_{0};    // 其中属于热数据（新写入的对象）的块数
+  int last_size_{0}; // 上一次垃圾回收时的 size_
+  int lender_{-1};    // 拆分时从哪个标签的段分出来，到下一次垃圾回收为止
+  // 按大小分类的空闲区：extents_[s] 是删除大小为 s 的对象后留下的连续空闲块
+  // 的起点，使用前需要检查是否仍然空闲、仍然属于本段
+  std::array<std::vector<int>, config::MAX_OBJECT_SIZE + 1> extents_;
+  int tail_;      // 段内最后一个被占用的块之后的位置，空段为 disk_addr_
 
   // 构造函数
   // 参数：
@@ -26,7 +34,10 @@ public:
   // - capacity: 段的总容量（默认值为 DEFAULT_CAPACITY）
   Segment(int disk_id, int disk_addr, int tag, int capacity = DEFAULT_CAPACITY)
       : disk_id_(disk_id), disk_addr_(disk_addr), tag_(tag),
-        capacity_(capacity) {}
+        capacity_(capacity), tail_(disk_addr) {}
+
+  // 段内 tail_ 之前的空洞数，也就是把段压紧所需的最少移动次数
+  auto Holes() const -> int { return tail_ - disk_addr_ - used_; }
 
   // 扩展段的容量
   // 参数：
@@ -51,6 +62,11 @@ class SegmentManager {
 public:
   std::vector<std::list<Segment>> segs_; // 每个标签对应的段列表
   std::vector<int> seg_disk_capacity_, seg_disk_size_;
+  // 每个磁盘上第二个磁头区域的段开始的位置，段按起点属于某个磁头区域
+  std::vector<int> zone_;
+  // 每个磁盘每个块所在的段，不在任何段内为 nullptr
+  // 同一磁盘上的段互不重叠，段在 std::list 中地址不变，可以直接保存指针
+  std::vector<std::vector<Segment *>> owner_;
 
   using data_t = std::vector<std::vector<int>>; // 数据类型，用于初始化段
 
@@ -62,7 +78,8 @@ public:
   // - t: 每个标签在每个磁盘上的初始分配
   SegmentManager(int M, int N, int V, const data_t &t,
                  const std::vector<std::vector<int>> &tsp)
-      : segs_(M), seg_disk_capacity_(N), seg_disk_size_(N) {
+      : segs_(M), seg_disk_capacity_(N), seg_disk_size_(N), zone_(N),
+        owner_(N, std::vector<Segment *>(V, nullptr)) {
     for (int i = 0; i < N; i++) {   // 遍历每个磁盘
       int addr = 0;                 // 当前磁盘的起始地址
       int rem = V;                  // 当前磁盘的剩余容量
@@ -71,14 +88,17 @@ public:
         auto cur = std::min(t[j][i], rem); // 当前标签在该磁盘上的分配
         segs_[j].emplace_back(i, addr, j,
                               cur); // 创建段并添加到对应标签的段列表
+        Claim(&segs_[j].back());    // 登记段覆盖的块
         rem -= cur;                 // 更新剩余容量
         addr += cur;                // 更新起始地址
       }
+      zone_[i] = addr;
       for (int _ = 0; _ < M; _++) { // 遍历每个标签
         int j = tsp[i + N][_];
         auto cur = std::min(t[j][i + N], rem); // 当前标签在该磁盘上的分配
         segs_[j].emplace_back(i, addr, j,
                               cur); // 创建段并添加到对应标签的段列表
+        Claim(&segs_[j].back());    // 登记段覆盖的块
         rem -= cur;                 // 更新剩余容量
         addr += cur;                // 更新起始地址
       }
@@ -86,6 +106,25 @@ public:
     }
   }
 
+  // 段所在的磁头区域，编号和初始化的分配方案的列相同：
+  // 磁盘 i 的第一个区域是 i，第二个区域是 i + N
+  auto Zone(const Segment *seg) const -> int {
+    int d = seg->disk_id_;
+    return seg->disk_addr_ < zone_[d] ? d : d + static_cast<int>(zone_.size());
+  }
+
+  // 各段当前的容量，格式和初始化的分配方案相同：标签 × 磁头区域
+  auto Layout() const -> std::vector<std::vector<int>> {
+    std::vector<std::vector<int>> res(segs_.size(),
+                                      std::vector<int>(2 * zone_.size(), 0));
+    for (int j = 0, m = segs_.size(); j < m; j++) {
+      for (const auto &seg : segs_[j]) {
+        res[j][Zone(&seg)] += seg.capacity_;
+      }
+    }
+    return res;
+  }
+
   // 查找满足条件的段
   // 参数：
   // - tag: 段的标签
@@ -94,20 +133,20 @@ public:
   // 返回值：指向满足条件的段的指针，如果没有找到则返回 nullptr
   auto Find(int tag, int disk_id, int size) -> Segment * {
     static std::mt19937 rng(config::RANDOM_SEED);
-    std::array<Segment *, 3> vec;
-    int tot = 0;
+    static std::vector<Segment *> vec; // 拆分后一个标签在一个磁盘上可能有多个段
+    vec.clear();
     for (auto &s : segs_[tag]) {   // 遍历指定标签的段列表
       if (s.disk_id_ != disk_id) { // 如果段不在指定磁盘上，跳过
         continue;
       }
       if (s.size_ + size <= s.capacity_) { // 如果段有足够的剩余容量
-        vec[tot++] = &s;                   // 返回段的指针
+        vec.push_back(&s);                 // 记为候选
       }
     }
-    if (tot == 0) {
+    if (vec.empty()) {
       return nullptr; // 没有找到满足条件的段
     }
-    return vec[rng() % tot];
+    return vec[rng() % vec.size()];
   }
 
   // 查找包含指定块的段
@@ -117,15 +156,21 @@ public:
   // - block_id: 块 ID
   // 返回值：指向包含指定块的段的指针，如果没有找到则返回 nullptr
   auto FindBlock(int tag, int disk_id, int block_id) -> Segment * {
-    for (auto &s : segs_[tag]) {   // 遍历指定标签的段列表
-      if (s.disk_id_ != disk_id) { // 如果段不在指定磁盘上，跳过
-        continue;
-      }
-      if (s.disk_addr_ <= block_id && block_id < s.disk_addr_ + s.capacity_) {
-        return &s;
-      }
-    }
-    return nullptr;
+    auto ptr = Locate(disk_id, block_id);
+    return ptr != nullptr && ptr->tag_ == tag ? ptr : nullptr;
+  }
+
+  // 查找包含指定块的段（不限标签）
+  // 返回值：指向包含指定块的段的指针，如果块不在任何段内则返回 nullptr
+  auto Locate(int disk_id, int block_id) const -> Segment * {
+    return owner_[disk_id][block_id];
+  }
+
+  // 登记段 seg 覆盖的块，段的地址或容量变化后需要重新登记
+  void Claim(Segment *seg) {
+    auto &own = owner_[seg->disk_id_];
+    std::fill(own.begin() + seg->disk_addr_,
+              own.begin() + seg->disk_addr_ + seg->capacity_, seg);
   }
 
   auto FreeBlockSize(int idx) {
@@ -143,32 +188,206 @@ public:
   // - block_id: 块 ID
   // 返回值：布尔值，表示是否成功删除
   auto Delete(int tag, int disk_id, int block_id) {
-    for (auto &s : segs_[tag]) {   // 遍历指定标签的段列表
-      if (s.disk_id_ != disk_id) { // 如果段不在指定磁盘上，跳过
+    auto ptr = FindBlock(tag, disk_id, block_id);
+    if (ptr == nullptr) {
+      return false; // 没有找到包含指定块的段
+    }
+    seg_disk_size_[disk_id]--;
+    ptr->Delete(1); // 从段中删除一个块
+    return true;    // 删除成功
+  }
+
+  // 在磁盘 disk_id 的 [addr, addr + len) 上为标签 tag 新建一个段
+  // 调用方保证这些块空闲且不属于任何段
+  auto Add(int disk_id, int addr, int tag, int len) -> Segment * {
+    auto &seg = segs_[tag].emplace_back(disk_id, addr, tag, len);
+    Claim(&seg);
+    return &seg;
+  }
+
+  // 段向后扩展至多 len 个块，只占用不属于任何段的块，并且不超过所在
+  // 磁头区域的末尾，调用方保证这些块是空闲的
+  // 返回值：实际扩展的块数
+  auto Grow(Segment *seg, int len) -> int {
+    int d = seg->disk_id_;
+    auto &own = owner_[d];
+    int end = seg->disk_addr_ + seg->capacity_;
+    int zone = seg->disk_addr_ < zone_[d] ? zone_[d] : seg_disk_capacity_[d];
+    int lim = std::min(end + len, zone);
+    int cur = end;
+    while (cur < lim && own[cur] == nullptr) {
+      own[cur++] = seg;
+    }
+    seg->capacity_ += cur - end;
+    return cur - end;
+  }
+
+  // 段向后扩展 len 个块：这些块不属于任何段，或者是紧跟其后的段开头的
+  // 空闲块（那个段的起点后移），调用方保证这些块空闲
+  void GrowBack(Segment *seg, int len) {
+    int end = seg->disk_addr_ + seg->capacity_;
+    if (auto nx = Locate(seg->disk_id_, end); nx != nullptr) {
+      assert(nx->disk_addr_ == end && len <= nx->capacity_);
+      nx->disk_addr_ += len;
+      nx->capacity_ -= len;
+      nx->tail_ = std::max(nx->tail_, nx->disk_addr_);
+    }
+    seg->capacity_ += len;
+    Claim(seg);
+  }
+
+  // 段向前扩展 len 个块：这些块不属于任何段，或者是紧挨在前面的段尾部的
+  // 空闲块（那个段收缩），调用方保证这些块空闲
+  void GrowFront(Segment *seg, int len) {
+    int a = seg->disk_addr_;
+    if (auto pv = Locate(seg->disk_id_, a - 1); pv != nullptr) {
+      assert(pv->disk_addr_ + pv->capacity_ == a && len <= pv->capacity_);
+      pv->capacity_ -= len;
+      assert(pv->tail_ <= a - len);
+    }
+    seg->disk_addr_ -= len;
+    seg->capacity_ += len;
+    if (seg->used_ == 0) {
+      seg->tail_ = seg->disk_addr_; // 空段的 tail_ 跟着段首走
+    }
+    Claim(seg);
+  }
+
+  // 释放段尾部多余的容量，段收缩到 cap 个块，释放的块不再属于任何段
+  // 调用方保证释放的块都是空闲的
+  void Shrink(Segment *seg, int cap) {
+    assert(seg->disk_addr_ + cap >= seg->tail_);
+    auto &own = owner_[seg->disk_id_];
+    std::fill(own.begin() + seg->disk_addr_ + cap,
+              own.begin() + seg->disk_addr_ + seg->capacity_, nullptr);
+    seg->capacity_ = cap;
+  }
+
+  // 把段 seg 中间的空闲块 [a, a + len) 分给标签 tag：seg 保留 a 之前的部分，
+  // a + len 之后的部分成为同标签的新段
+  // 各段的 used_ / hot_ / tail_ / size_ 由调用方重新统计
+  // 返回值：{分给 tag 的新段, seg 的后半段（没有时为 nullptr）}
+  auto Split(Segment *seg, int a, int len, int tag)
+      -> std::pair<Segment *, Segment *> {
+    int end = seg->disk_addr_ + seg->capacity_;
+    assert(seg->disk_addr_ <= a && a + len <= end);
+    assert(a > seg->disk_addr_); // seg 至少留下一个块
+    auto &mid = segs_[tag].emplace_back(seg->disk_id_, a, tag, len);
+    mid.lender_ = seg->tag_;
+    Claim(&mid);
+    Segment *right = nullptr;
+    if (a + len < end) {
+      right = &segs_[seg->tag_].emplace_back(seg->disk_id_, a + len,
+                                             seg->tag_, end - a - len);
+      Claim(right);
+    }
+    seg->capacity_ = a - seg->disk_addr_;
+    return {&mid, right};
+  }
+
+  // 按地址顺序整理磁盘 disk_id 上的段，后一个段并进前一个段：
+  // - 拆分时分出去、到下一次垃圾回收还没写入过的段还给借出它的标签
+  // - 相邻的同标签段合并，拆分和归还留下的碎段不会越积越多
+  // 不跨过两个磁头区域的分界
+  // 返回值：合并掉的段数
+  auto Merge(int disk_id) -> int {
+    auto &own = owner_[disk_id];
+    int merged = 0;
+    Segment *prev = nullptr;
+    for (int a = 0, end = seg_disk_capacity_[disk_id]; a < end;) {
+      Segment *seg = own[a];
+      if (seg == nullptr) {
+        prev = nullptr;
+        ++a;
         continue;
       }
-      if (s.disk_addr_ <= block_id && block_id < s.disk_addr_ + s.capacity_) {
-        // 如果块在段的范围内
-        seg_disk_size_[disk_id]--;
-        s.Delete(1); // 从段中删除一个块
-        return true; // 删除成功
+      a = seg->disk_addr_ + seg->capacity_;
+      if (seg->lender_ != -1 && seg->used_ == 0 && seg->size_ == 0) {
+        Retag(seg, seg->lender_);
       }
+      seg->lender_ = -1;
+      if (prev != nullptr && seg->disk_addr_ != zone_[disk_id] &&
+          prev->tag_ == seg->tag_) {
+        Absorb(prev, seg);
+        ++merged;
+        continue;
+      }
+      prev = seg;
     }
-    return false; // 没有找到包含指定块的段
+    return merged;
   }
-  auto Trans(int disk_id, int x, int y) -> void {
-    for (auto &lst : segs_) {
-      for (auto &s : lst) {          // 遍历所有标签的段列表
-        if (s.disk_id_ != disk_id) { // 如果段不在指定磁盘上，跳过
-          continue;
-        }
-        if (s.disk_addr_ <= x && x < s.disk_addr_ + s.capacity_) {
-          s.Delete(1); // 从段中删除一个块
-        }
-        if (s.disk_addr_ <= y && y < s.disk_addr_ + s.capacity_) {
-          s.Write(1); // 从段中删除一个块
-        }
+
+  // 块 block 被占用
+  // 参数：
+  // - hot: 块是否属于热数据
+  void Occupy(int disk_id, int block_id, bool hot = false) {
+    if (auto ptr = Locate(disk_id, block_id); ptr != nullptr) {
+      ++ptr->used_;
+      ptr->hot_ += hot ? 1 : 0;
+      ptr->tail_ = std::max(ptr->tail_, block_id + 1);
+    }
+  }
+
+  // 块 block 被释放
+  // 参数：
+  // - prev_used: 磁盘上不大于 block 的最后一个仍被占用的块，没有为 -1
+  // - hot: 块是否属于热数据
+  void Vacate(int disk_id, int block_id, int prev_used, bool hot = false) {
+    if (auto ptr = Locate(disk_id, block_id); ptr != nullptr) {
+      assert(ptr->used_ > 0);
+      --ptr->used_;
+      ptr->hot_ -= hot ? 1 : 0;
+      if (block_id + 1 == ptr->tail_) {
+        ptr->tail_ = std::max(ptr->disk_addr_, prev_used + 1);
       }
     }
   }
+
+  // 块 block 上的数据从热变冷
+  void Cool(int disk_id, int block_id) {
+    if (auto ptr = Locate(disk_id, block_id); ptr != nullptr) {
+      assert(ptr->hot_ > 0);
+      --ptr->hot_;
+    }
+  }
+
+  // 段 seg 改属标签 tag，段节点在 std::list 之间移动，地址不变
+  void Retag(Segment *seg, int tag) {
+    auto &from = segs_[seg->tag_];
+    auto it = std::find_if(from.begin(), from.end(),
+                           [&](const Segment &s) { return &s == seg; });
+    segs_[tag].splice(segs_[tag].end(), from, it);
+    seg->tag_ = tag;
+  }
+
+  // 段 right 紧跟在段 left 之后，把它并进 left 并删除
+  void Absorb(Segment *left, Segment *right) {
+    assert(left->disk_addr_ + left->capacity_ == right->disk_addr_);
+    left->capacity_ += right->capacity_;
+    left->size_ += right->size_;
+    left->used_ += right->used_;
+    left->hot_ += right->hot_;
+    left->last_size_ += right->last_size_;
+    if (right->used_ > 0) {
+      left->tail_ = right->tail_;
+    }
+    for (int s = 0; s <= config::MAX_OBJECT_SIZE; s++) {
+      auto &from = right->extents_[s];
+      left->extents_[s].insert(left->extents_[s].end(), from.begin(), from.end());
+    }
+    Claim(left);
+    auto &list = segs_[right->tag_];
+    list.erase(std::find_if(list.begin(), list.end(),
+                            [&](const Segment &s) { return &s == right; }));
+  }
+
+  // 块从 x 移动到 y，更新两端所在段的大小
+  auto Trans(int disk_id, int x, int y) -> void {
+    if (auto ptr = Locate(disk_id, x); ptr != nullptr) {
+      ptr->Delete(1); // 从段中删除一个块
+    }
+    if (auto ptr = Locate(disk_id, y); ptr != nullptr) {
+      ptr->Write(1); // 向段中写入一个块
+    }
+  }
 };
\ No newline at end of file
@@ -1,29 +1,138 @@
 #pragma once
+#include "config.h"
 #include <bits/stdc++.h>
 // only read task
+// 任务状态
+enum class TaskState : uint8_t {
+  free,    // 槽位空闲
+  pending, // 等待读取，挂在超时时间轮上
+  busy     // 超时，已经上报繁忙，但对象的块还没读完
+};
+
+// 任务句柄：槽位下标 + 代数，槽位回收重用后旧句柄失效
+struct TaskHandle {
+  int idx_;      // 槽位下标
+  uint32_t gen_; // 槽位的代数
+};
+
 // 任务结构体，用于表示只读任务
+// 一个读请求只从一个磁盘读对象的一个副本，要读的块就是 tdisk_[replica_]，
+// 垃圾回收移动块时对象本身会更新，这里不需要再保存一份块列表
 struct Task {
-  // 构造函数
-  // 参数：
-  // - tid: 任务的唯一标识符
-  // - oid: 任务关联的对象 ID
-  // - timestamp: 任务的时间戳
-  Task(int tid, int oid, int timestamp, std::vector<std::pair<int, int>> &&work)
-      : tid_(tid), oid_(oid), timestamp_(timestamp), work_(std::move(work)) {}
-
-  // x -> y
-  void TransWork(int x, int y) {
-    for (auto &[a, b] : work_) {
-      if (b == x) {
-        b = y;
-      }
+  int tid_;       // 任务的唯一标识符
+  int oid_;       // 任务关联的对象 ID
+  int timestamp_; // 任务的时间戳，用于记录任务的创建时间
+  int disk_;      // 读取的磁盘 ID（包括镜像磁盘）
+  int replica_;   // 读取的副本编号
+  int remain_{0}; // 还没有读到的块数，为 0 时任务完成
+  int slot_{-1};  // 在 TaskManager 未完成任务列表中的下标
+  int prev_{-1};  // 时间轮同一格中的前一个任务
+  int next_{-1};  // 时间轮同一格中的后一个任务
+  uint32_t gen_{0};                   // 槽位的代数
+  TaskState state_{TaskState::free};  // 任务状态
+};
+
+// 任务池：槽位连续存放，空闲槽位用栈回收，不为每个请求单独分配内存
+// 等待中的任务按到达时间片挂在时间轮上（槽位内的双向链表），读完或被删除时
+// O(1) 摘下，超时扫描只会碰到真正超时的任务
+// 时间轮有 REQ_BUSY_TIME + 1 格：扫描时间片 t - REQ_BUSY_TIME 时，
+// 时间片 t 刚到达的任务已经挂上去了，两者不能落在同一格
+class TaskPool {
+public:
+  static constexpr int WHEEL_SIZE = config::REQ_BUSY_TIME + 1;
+
+  TaskPool() { head_.fill(-1); }
+
+  // 创建新任务
+  // 返回值：任务句柄
+  auto New(int tid, int oid, int timestamp, int disk, int replica)
+      -> TaskHandle {
+    int idx;
+    if (!free_.empty()) {
+      idx = free_.back();
+      free_.pop_back();
+    } else {
+      idx = slots_.size();
+      slots_.emplace_back();
+    }
+    auto &t = slots_[idx];
+    t.tid_ = tid;
+    t.oid_ = oid;
+    t.timestamp_ = timestamp;
+    t.disk_ = disk;
+    t.replica_ = replica;
+    t.remain_ = 0;
+    t.slot_ = -1;
+    t.state_ = TaskState::pending;
+    Link(idx);
+    return {idx, t.gen_};
+  }
+
+  // 句柄是否仍然指向有效的任务
+  auto Valid(TaskHandle h) const -> bool {
+    return h.idx_ >= 0 && h.idx_ < static_cast<int>(slots_.size()) &&
+           slots_[h.idx_].gen_ == h.gen_ &&
+           slots_[h.idx_].state_ != TaskState::free;
+  }
+
+  auto Get(TaskHandle h) -> Task & {
+    assert(Valid(h));
+    return slots_[h.idx_];
+  }
+
+  // 回收任务的槽位，代数加一使旧句柄失效
+  void Release(TaskHandle h) {
+    assert(Valid(h));
+    auto &t = slots_[h.idx_];
+    if (t.state_ == TaskState::pending) {
+      Unlink(h.idx_);
+    }
+    t.state_ = TaskState::free;
+    ++t.gen_;
+    free_.push_back(h.idx_);
+  }
+
+  // 对时间片 slice 到达、仍在等待的所有任务调用 f，并把它们从时间轮摘下
+  // f 需要把任务改成非等待状态
+  template <typename F> void Expire(int slice, const F &f) {
+    int &head = head_[slice % WHEEL_SIZE];
+    for (int i = head; i != -1;) {
+      auto &t = slots_[i];
+      assert(t.state_ == TaskState::pending && t.timestamp_ == slice);
+      i = t.next_;
+      t.prev_ = t.next_ = -1;
+      f(t);
+    }
+    head = -1;
+  }
+
+private:
+  // 挂到到达时间片对应的格子
+  void Link(int idx) {
+    auto &t = slots_[idx];
+    int &head = head_[t.timestamp_ % WHEEL_SIZE];
+    t.prev_ = -1;
+    t.next_ = head;
+    if (head != -1) {
+      slots_[head].prev_ = idx;
+    }
+    head = idx;
+  }
+
+  void Unlink(int idx) {
+    auto &t = slots_[idx];
+    if (t.prev_ != -1) {
+      slots_[t.prev_].next_ = t.next_;
+    } else {
+      head_[t.timestamp_ % WHEEL_SIZE] = t.next_;
+    }
+    if (t.next_ != -1) {
+      slots_[t.next_].prev_ = t.prev_;
     }
+    t.prev_ = t.next_ = -1;
   }
 
-  int tid_;                        // 任务的唯一标识符
-  int oid_;                        // 任务关联的对象 ID
-  [[maybe_unused]] int timestamp_; // 任务的时间戳，用于记录任务的创建时间
-  [[maybe_unused]] int order_; // 任务的顺序，用于调度时的优先级或排序
-  std::vector<std::pair<int, int>>
-      work_; // 记录对象的每个块是由哪个磁盘读, 在哪个块
-};
\ No newline at end of file
+  std::vector<Task> slots_;             // 任务槽位
+  std::vector<int> free_;               // 空闲槽位
+  std::array<int, WHEEL_SIZE> head_{};  // 时间轮每一格的链表头
+};
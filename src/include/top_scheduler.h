@@ -1,3 +1,5 @@
+#pragma once
+
 #include "config.h"
 #include "disk.h"
 #include "disk_manager.h"
@@ -70,16 +72,11 @@ public:
       }
     }
 
-    std::vector<std::pair<int, int>> work;
-    work.reserve(object->size_);
     // 怎么分给两个镜像呢
     for (int i = 0; i < object->size_; i++) {
       scheduler_->PushRTQ(disk, object->tdisk_[x][i]); // 将块 ID 添加到读取队列
-      work.emplace_back(disk, object->tdisk_[x][i]);
     }
-    scheduler_->NewTask(oid,
-                        std::make_shared<Task>(tid, oid, timeslice,
-                                               std::move(work))); // 创建新任务
+    scheduler_->NewTask(tid, oid, disk, x); // 创建新任务
   }
 
   // 处理插入请求
@@ -116,6 +113,7 @@ public:
       for (auto y : object->tdisk_[i]) {
         disk_mgr_->Delete(object->tag_, disk_id, y); // 从磁盘中删除块
       }
+      disk_mgr_->Recycle(disk_id, object->tdisk_[i]); // 登记空出的连续块
     }
 
     obj_pool_->Drop(oid); // 将对象标记为无效
@@ -1,38 +1,141 @@
 #pragma once
 
 #include "config.h"
+#include "deadline.h"
 #include <algorithm>
 #include <climits>
+#include <cstdint>
 #include <iostream>
+#include <numeric>
 #include <vector>
 
-// TSP 动态规划求解 + 路径回溯
-auto TSP(int n, const std::vector<std::vector<db>> &dist) -> std::vector<int> {
+// 路径总权值（相邻两点 dist 之和）
+auto PathWeight(const std::vector<int> &path,
+                       const std::vector<std::vector<db>> &dist) -> db {
+  db sum = 0;
+  for (int k = 0; k + 1 < static_cast<int>(path.size()); k++) {
+    sum += dist[path[k]][path[k + 1]];
+  }
+  return sum;
+}
+
+// 启发式求权值最大的哈密顿路径：贪心构造 + 2-opt + Or-opt，直到没有改进
+auto TSPHeuristic(int n, const std::vector<std::vector<db>> &dist)
+    -> std::vector<int> {
+  // 每次走到权值最大的未访问城市
+  std::vector<int> path = {0};
+  std::vector<bool> vis(n, false);
+  vis[0] = true;
+  for (int k = 1; k < n; k++) {
+    int u = path.back();
+    int nxt = -1;
+    for (int v = 0; v < n; v++) {
+      if (!vis[v] && (nxt == -1 || dist[u][v] > dist[u][nxt])) {
+        nxt = v;
+      }
+    }
+    vis[nxt] = true;
+    path.push_back(nxt);
+  }
+
+  // 开放路径上 p[a] 和 p[b] 之间的边权，越界视为 0
+  auto w = [&](int a, int b) -> db {
+    if (a < 0 || b >= n) {
+      return 0;
+    }
+    return dist[path[a]][path[b]];
+  };
+  constexpr db EPS = 1e-9;
+  for (bool improved = true; improved && !deadline::Expired();) {
+    improved = false;
+    // 2-opt：翻转 [i, k]
+    for (int i = 0; i < n; i++) {
+      for (int k = i + 1; k < n; k++) {
+        db delta = (i > 0 ? dist[path[i - 1]][path[k]] : 0) +
+                   (k + 1 < n ? dist[path[i]][path[k + 1]] : 0) - w(i - 1, i) -
+                   w(k, k + 1);
+        if (delta > EPS) {
+          std::reverse(path.begin() + i, path.begin() + k + 1);
+          improved = true;
+        }
+      }
+    }
+    // Or-opt：把长度 1~3 的一段挪到别的位置
+    for (int len = 1; len <= 3; len++) {
+      for (int i = 0; i + len <= n; i++) {
+        db removed = w(i - 1, i) + w(i + len - 1, i + len) -
+                     (i > 0 && i + len < n ? dist[path[i - 1]][path[i + len]]
+                                           : 0);
+        std::vector<int> seg(path.begin() + i, path.begin() + i + len);
+        std::vector<int> rest(path.begin(), path.begin() + i);
+        rest.insert(rest.end(), path.begin() + i + len, path.end());
+        int best_pos = -1;
+        db best_gain = EPS;
+        for (int p = 0; p <= static_cast<int>(rest.size()); p++) {
+          if (p == i) {
+            continue; // 原位置
+          }
+          db add = (p > 0 ? dist[rest[p - 1]][seg.front()] : 0) +
+                   (p < static_cast<int>(rest.size())
+                        ? dist[seg.back()][rest[p]]
+                        : 0) -
+                   (p > 0 && p < static_cast<int>(rest.size())
+                        ? dist[rest[p - 1]][rest[p]]
+                        : 0);
+          if (add - removed > best_gain) {
+            best_gain = add - removed;
+            best_pos = p;
+          }
+        }
+        if (best_pos != -1) {
+          rest.insert(rest.begin() + best_pos, seg.begin(), seg.end());
+          path = std::move(rest);
+          improved = true;
+        }
+      }
+    }
+  }
+  return path;
+}
+
+// TSP 动态规划求解 + 路径回溯，求权值最大的哈密顿路径
+// dp 和 parent 都是 (1 << n) * n 的连续数组，按位枚举已访问/未访问的城市
+// 时间预算用完时放弃 DP，改用启发式
+auto TSPExact(int n, const std::vector<std::vector<db>> &dist)
+    -> std::vector<int> {
   int full_mask = (1 << n) - 1; // 终态：所有城市都访问过
-  std::vector<std::vector<db>> dp(
-      1 << n, std::vector<db>(
-                  n, -config::INF)); // dp[S][i]: 访问 S，最后停在 i 的最短路径
-  std::vector<std::vector<int>> parent(1 << n,
-                                       std::vector<int>(n, -1)); // 记录转移路径
+  // dp[S * n + i]: 访问 S，最后停在 i 的最长路径
+  std::vector<db> dp(static_cast<size_t>(1 << n) * n, -config::INF);
+  std::vector<int8_t> parent(static_cast<size_t>(1 << n) * n, -1); // 记录转移路径
+  std::vector<db> d(n * n);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      d[i * n + j] = dist[i][j];
+    }
+  }
   for (int i = 0; i < n; i++) {
-    dp[1 << i][i] = 0; // 初始状态：仅访问了起点 0
+    dp[static_cast<size_t>(1 << i) * n + i] = 0; // 初始状态：仅访问了起点 i
   }
 
   // 动态规划求解
-  for (int s = 1; s < (1 << n); s++) {
-    for (int i = 0; i < n; i++) {
-      if ((s & (1 << i)) == 0) {
-        continue;
-      } // i 不在 s 中，跳过
-      for (int j = 0; j < n; j++) {
-        if ((s & (1 << j)) > 0) {
-          continue;
-        } // j 已访问 或 i==j 跳过
-        int new_s = (s | (1 << j)); // 新状态，加入 j
-        db res = dp[s][i] + dist[i][j];
-        if (dp[new_s][j] < res) {
-          dp[new_s][j] = res;
-          parent[new_s][j] = i; // 记录 j 的前驱是 i
+  for (int s = 1; s < full_mask; s++) {
+    if ((s & 4095) == 0 && deadline::Expired()) {
+      return TSPHeuristic(n, dist);
+    }
+    const db *cur = &dp[static_cast<size_t>(s) * n];
+    for (unsigned in = s; in != 0; in &= in - 1) {
+      int i = __builtin_ctz(in);
+      if (cur[i] == -config::INF) {
+        continue; // 不可达的状态
+      }
+      const db *di = &d[i * n];
+      for (unsigned out = full_mask & ~s; out != 0; out &= out - 1) {
+        int j = __builtin_ctz(out);
+        size_t idx = static_cast<size_t>(s | (1 << j)) * n + j; // 新状态，加入 j
+        db res = cur[i] + di[j];
+        if (dp[idx] < res) {
+          dp[idx] = res;
+          parent[idx] = static_cast<int8_t>(i); // 记录 j 的前驱是 i
         }
       }
     }
@@ -40,10 +143,10 @@ auto TSP(int n, const std::vector<std::vector<db>> &dist) -> std::vector<int> {
 
   // 找到最优解，并回溯路径
   db max_fitness = -config::INF;
-  int last_city = -1;
+  int last_city = n == 1 ? 0 : -1;
   for (int j = 1; j < n; j++) {
-    if (dp[full_mask][j] > max_fitness) {
-      max_fitness = dp[full_mask][j];
+    if (dp[static_cast<size_t>(full_mask) * n + j] > max_fitness) {
+      max_fitness = dp[static_cast<size_t>(full_mask) * n + j];
       last_city = j;
     }
   }
@@ -53,11 +156,19 @@ auto TSP(int n, const std::vector<std::vector<db>> &dist) -> std::vector<int> {
   int state = full_mask;
   while (last_city != -1) {
     path.push_back(last_city);
-    int prev_city = parent[state][last_city];
+    int prev_city = parent[static_cast<size_t>(state) * n + last_city];
     state ^= (1 << last_city); // 移除 last_city
     last_city = prev_city;
   }
-  // path.push_back(0); // 最后回到起点
   std::reverse(path.begin(), path.end()); // 逆序得到正确路径
   return path;
 }
+
+// 求权值最大的哈密顿路径，规模不超过 TSP_EXACT_MAX 时用精确 DP，否则用启发式
+auto TSP(int n, const std::vector<std::vector<db>> &dist)
+    -> std::vector<int> {
+  if (n <= config::TSP_EXACT_MAX) {
+    return TSPExact(n, dist);
+  }
+  return TSPHeuristic(n, dist);
+}
@@ -1,11 +1,16 @@
 #include "include/config.h"
 #include "include/data.h"
+#include "include/deadline.h"
 #include "include/disk.h"
 #include "include/disk_manager.h"
+#include "include/gc_bench.h"
 #include "include/init.h"
 #include "include/object.h"
 #include "include/printer.h"
+#include "include/reader.h"
+#include "include/replan.h"
 #include "include/resource_allocator.h"
+#include "include/rtq_bench.h"
 #include "include/scheduler.h"
 #include "include/top_scheduler.h"
 #include "include/tsp.h"
@@ -15,6 +20,7 @@
 #include <iostream>
 #include <limits>
 #include <numeric>
+#include <optional>
 #include <thread>
 #include <vector>
 
@@ -29,12 +35,27 @@ auto main() -> int {
 
 
 
+#ifdef RTQ_BENCH
+  bench::RTQBench();
+  return 0;
+#endif
+#ifdef GC_BENCH
+  bench::GCBench();
+  return 0;
+#endif
+
   std::ios::sync_with_stdio(false);
   std::cin.tie(nullptr);
+  reader::Init(); // 初始化输入层
+  reader::flush_hook = printer::Flush; // 等待输入前先写出已有的输出
 
   int t, m, n, v, g,k; // NOLINT
-  std::cin >> t >> m >> n >> v >>
-      g >> k; // 输入时间片数量、标签数量、磁盘数量、磁盘容量、生命周期
+  t = reader::NextInt();
+  m = reader::NextInt();
+  n = reader::NextInt();
+  v = reader::NextInt();
+  g = reader::NextInt();
+  k = reader::NextInt(); // 输入时间片数量、标签数量、磁盘数量、磁盘容量、生命周期
   config::REAL_DISK_CNT = n;
   config::RTQ_DISK_PART_SIZE = v / m;
   config::JUMP_THRESHOLD = config::RTQ_DISK_PART_SIZE;
@@ -46,27 +67,27 @@ auto main() -> int {
   // 输入数据
   for (int i = 0; i < m; i++) {
     for (int j = 0; j < (t - 1) / TIME_SLICE_DIVISOR + 1; j++) {
-      std::cin >> delete_data[i][j];
+      delete_data[i][j] = reader::NextInt();
     }
   }
   for (int i = 0; i < m; i++) {
     for (int j = 0; j < (t - 1) / TIME_SLICE_DIVISOR + 1; j++) {
-      std::cin >> write_data[i][j];
+      write_data[i][j] = reader::NextInt();
     }
   }
   for (int i = 0; i < m; i++) {
     for (int j = 0; j < (t - 1) / TIME_SLICE_DIVISOR + 1; j++) {
-      std::cin >> read_data[i][j]; // 读取数据
+      read_data[i][j] = reader::NextInt(); // 读取数据
     }
   }
   std::vector<int> extra_tokens((t + 104) / TIME_SLICE_DIVISOR + 1);//NOLINT
   for(auto &it : extra_tokens){
-    std::cin >> it;
+    it = reader::NextInt();
   }
-  // 初始化资源分配器并进行模拟退火优化
-  auto [best_solution, alpha] = InitResourceAllocator(
-      t, m, n, v, g, delete_data, write_data, read_data); // 获取最优解
-  auto tsp = InitTSP(n, m, alpha, best_solution); // 初始化 TSP 问题
+  deadline::Start(config::INIT_TIME_BUDGET_MS); // 初始化阶段的时间预算
+  // 初始化资源分配（模拟退火等）和 TSP，可能命中本地缓存
+  auto [best_solution, alpha, tsp] = Initialize(
+      t, m, n, v, g, k, delete_data, write_data, read_data); // 获取最优解
 
   // 初始化对象池、调度器、段管理器和磁盘管理器
   ObjectPool pool(t);
@@ -74,24 +95,27 @@ auto main() -> int {
   SegmentManager seg_mgr(m, n, v, best_solution, tsp);
   DiskManager dm(&pool, &none, &seg_mgr,alpha, n,m, v, g,k);
   TopScheduler tes(&none, &pool, &dm,v);
+  std::optional<Replanner> replanner; // 在线重新分配，关闭时不复制预测数据
+  if constexpr (config::ONLINE_REPLAN) {
+    replanner.emplace(t, m, n, v, g, delete_data, write_data, read_data,
+                      best_solution);
+  }
 
   // 同步函数
   auto sync = []() -> bool {
-    std::string ts;
-    int time;
-    std::cin >> ts >> time;
-    (std::cout << "TIMESTAMP " << timeslice << '\n').flush();
+    int time = reader::ParseTimestamp();
+    printer::PrintTimestamp();
     return time == timeslice;
   };
 
   // 删除操作
   auto delete_op = [&]() -> void {
-    int n_delete;
-    std::cin >> n_delete;
-    for (int i = 0; i < n_delete; i++) {
-      int object_id;
-      std::cin >> object_id;
+    for (int object_id : reader::ParseDelete()) {
       --object_id; // 转换为 0 索引
+      if constexpr (config::ONLINE_REPLAN) {
+        auto object = pool.GetObjAt(object_id);
+        replanner->Delete(object->tag_, object->size_);
+      }
       tes.DeleteRequest(object_id);
     }
     printer::PrintDelete(); // 打印删除信息
@@ -99,13 +123,12 @@ auto main() -> int {
 
   // 写入操作
   auto write_op = [&]() -> void {
-    int n_write;
-    std::cin >> n_write;
-    for (int i = 0; i < n_write; i++) {
-      int id, size, tag; // NOLINT
-      std::cin >> id >> size >> tag;
+    for (auto [id, size, tag] : reader::ParseWrite()) {
       --id;
       --tag;
+      if constexpr (config::ONLINE_REPLAN) {
+        replanner->Write(tag, size);
+      }
       auto oid = tes.InsertRequest(id, size, tag); // 插入请求
       printer::AddInsertedObject(oid);             // 添加写入对象
     }
@@ -114,19 +137,18 @@ auto main() -> int {
 
   // 读取操作
   auto read_op = [&]() -> void {
-    int n_read;
-    std::cin >> n_read;
-    for (int i = 0; i < n_read; i++) {
-      int request_id, object_id; // NOLINT
-      std::cin >> request_id >> object_id;
+    for (auto [request_id, object_id] : reader::ParseRead()) {
       --object_id;                            // 转换为 0 索引
+      if constexpr (config::ONLINE_REPLAN) {
+        auto object = pool.GetObjAt(object_id);
+        replanner->Read(object->tag_, object->size_);
+      }
       tes.ReadRequest(request_id, object_id); // 读取请求
     }
   };
 
   auto gc_op = [&]() {
-    std::string tmp;
-    std::cin >> tmp >> tmp;
+    reader::ParseGC();
     dm.GarbageCollection(k); // 垃圾回收
     printer::GCPrint(n);
   };
@@ -143,6 +165,12 @@ auto main() -> int {
 
     printer::PrintRead(n); // 打印读取信息
     if (timeslice % 1800 == 0){
+      if constexpr (config::ONLINE_REPLAN) {
+        if (timeslice < t) {
+          dm.SetTarget(replanner->Replan(timeslice / TIME_SLICE_DIVISOR,
+                                        seg_mgr.Layout()));
+        }
+      }
       gc_op(); // 垃圾回收
     }
   #ifdef ISCERR
@@ -150,7 +178,10 @@ auto main() -> int {
       for(int i=0;i<2*n;i++){
         std::cerr<<dm.GetReadCount(i)<<'\n';
       }
+      dm.ReportGC();
+      reader::Report();
     }
   #endif
   }
-}
\ No newline at end of file
+  printer::Flush();
+}